@@ -0,0 +1,54 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <string_view>
+#include <vector>
+
+#include "print.hh"
+
+
+namespace bench
+{
+    using milliseconds = std::chrono::duration<double, std::milli>;
+
+
+    /**
+     * runs @p fn @p runs times and get the median of its run times
+     */
+    template <typename Fn>
+    [[nodiscard]]
+    auto
+    measure(std::size_t runs, Fn &&fn) -> milliseconds
+    {
+        std::vector<milliseconds> times;
+        times.reserve(runs);
+
+        for (std::size_t i { 0 }; i < runs; i++)
+        {
+            const auto start { std::chrono::steady_clock::now() };
+            fn();
+            times.emplace_back(std::chrono::steady_clock::now() - start);
+        }
+
+        std::ranges::nth_element(times, times.begin() + runs / 2);
+        return times[runs / 2];
+    }
+
+
+    inline void
+    report(std::string_view name, milliseconds time)
+    {
+        io::println("{:<40} {:>10.3f} ms", name, time.count());
+    }
+
+
+    /**
+     * keeps the compiler from optimizing away the computation of @p value
+     */
+    template <typename T>
+    void
+    keep(const T &value)
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+}
@@ -0,0 +1,125 @@
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bench.hh"
+#include "command/scanner.hh"
+#include "command/table.hh"
+
+namespace fs = std::filesystem;
+
+
+namespace
+{
+    constexpr std::size_t DIRECTORY_COUNT { 50 };
+    constexpr std::size_t ENTRIES_PER_DIRECTORY { 1000 };
+    constexpr std::size_t RUNS { 9 };
+
+
+    /**
+     * fills @p root with a synthetic $PATH, mostly executables, with a
+     * few plain files, symlinks and subdirectories the way real $PATH
+     * directories have them
+     */
+    [[nodiscard]]
+    auto
+    make_path(const fs::path &root) -> std::vector<std::string>
+    {
+        std::vector<std::string> dirs;
+
+        for (std::size_t d { 0 }; d < DIRECTORY_COUNT; d++)
+        {
+            const fs::path dir { root / std::format("bin{}", d) };
+            fs::create_directories(dir);
+            dirs.emplace_back(dir);
+
+            for (std::size_t i { 0 }; i < ENTRIES_PER_DIRECTORY; i++)
+            {
+                /* a third of the names repeat in every directory, so that
+                   precedence between them is exercised too */
+                const std::string name { i % 3 == 0
+                                             ? std::format("cmd{}", i)
+                                             : std::format("cmd{}-{}", d, i) };
+                const fs::path file { dir / name };
+
+                switch (i % 20)
+                {
+                case 0:  fs::create_directory(file); break;
+                case 1:  fs::create_symlink("/bin/sh", file); break;
+                default:
+                    std::ofstream { file };
+                    if (i % 20 != 2) chmod(file.c_str(), 0755);
+                    break;
+                }
+            }
+        }
+
+        return dirs;
+    }
+
+
+    /**
+     * lists @p dirs the way the binary path list was filled before the
+     * scanner, as a point of comparison
+     */
+    [[nodiscard]]
+    auto
+    scan_with_iterator(const std::vector<std::string> &dirs)
+        -> std::unordered_map<std::string, fs::path>
+    {
+        std::unordered_map<std::string, fs::path> binaries;
+
+        for (const auto &dir : dirs)
+            for (const auto &entry : fs::recursive_directory_iterator { dir })
+            {
+                if (!entry.is_regular_file()) continue;
+
+                const auto &file { entry.path() };
+                if (access(file.c_str(), X_OK) == 0)
+                    binaries[file.filename().string()] = file;
+            }
+
+        return binaries;
+    }
+}
+
+
+auto
+main() -> int
+{
+    const fs::path root { fs::temp_directory_path()
+                          / std::format("better-shell-scan-{}", getpid()) };
+    const auto dirs { make_path(root) };
+
+    io::println("{} directories of {} entries", DIRECTORY_COUNT,
+                ENTRIES_PER_DIRECTORY);
+
+    bench::report("recursive_directory_iterator",
+                  bench::measure(RUNS, [&]() -> void
+                                 { bench::keep(scan_with_iterator(dirs)); }));
+
+    std::vector<std::string> names;
+    bench::report("scan_directories",
+                  bench::measure(RUNS, [&]() -> void
+                                 { names = cmd::scan_directories(dirs); }));
+
+    std::vector<cmd::Table::directory_names> dir_names;
+    for (std::size_t i { 0 }; i < dirs.size(); i++)
+        dir_names.emplace_back(dirs[i], names[i]);
+
+    cmd::Table table;
+    bench::report("Table from the scanned names",
+                  bench::measure(RUNS, [&]() -> void
+                                 { table = cmd::Table { dir_names }; }));
+
+    io::println("{} executables", table.size());
+
+    fs::remove_all(root);
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include <string>
+
+#include "bench.hh"
+#include "parser/parser.hh"
+
+
+namespace
+{
+    constexpr std::size_t NESTING_DEPTH { 4000 };
+    constexpr std::size_t SUBSTITUTION_COUNT { 16000 };
+    constexpr std::size_t RUNS { 15 };
+
+
+    void
+    report_parse(std::string_view name, const std::string &text)
+    {
+        bench::report(name, bench::measure(RUNS, [&]() -> void
+                                           { bench::keep(parser::parse(
+                                                 "benchmark", text)); }));
+    }
+}
+
+
+auto
+main() -> int
+{
+    /* every level used to rescan everything inside it */
+    std::string nested { "echo " };
+    for (std::size_t i { 0 }; i < NESTING_DEPTH; i++) nested += "{ ls ";
+    nested.append(NESTING_DEPTH, '}');
+    report_parse("nested substitutions", nested);
+
+    /* and every substitution used to scan the rest of the line */
+    std::string flat { "echo" };
+    for (std::size_t i { 0 }; i < SUBSTITUTION_COUNT; i++) flat += " { ls }";
+    report_parse("consecutive substitutions", flat);
+
+    /* closing brackets that close nothing, and arithmetic expressions,
+       whose brackets the substitutions around them have to skip */
+    std::string stray { "echo" };
+    for (std::size_t i { 0 }; i < SUBSTITUTION_COUNT; i++)
+        stray += " { ls {{ 1 }} } }";
+    report_parse("stray closing brackets", stray);
+
+    std::string strings { "echo" };
+    for (std::size_t i { 0 }; i < SUBSTITUTION_COUNT; i++)
+        strings += R"( { echo "}" })";
+    report_parse("brackets inside strings", strings);
+
+    return 0;
+}
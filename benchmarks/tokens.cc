@@ -0,0 +1,152 @@
+#include <cstdlib>
+#include <format>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+
+#include "bench.hh"
+#include "parser/parser.hh"
+
+
+namespace
+{
+    constexpr std::size_t STEP_COUNT { 16000 };
+    constexpr std::size_t SMALL_TREE_COUNT { 2000 };
+    constexpr std::size_t SCANS_PER_RUN { 20 };
+    constexpr std::size_t RUNS { 15 };
+
+    /* the bytes currently allocated through operator new */
+    std::size_t LIVE_BYTES { 0 };
+
+
+    [[nodiscard]]
+    auto
+    track(void *ptr) -> void *
+    {
+        if (ptr == nullptr) throw std::bad_alloc {};
+
+        LIVE_BYTES += malloc_usable_size(ptr);
+        return ptr;
+    }
+
+
+    void
+    untrack(void *ptr) noexcept
+    {
+        if (ptr == nullptr) return;
+
+        LIVE_BYTES -= malloc_usable_size(ptr);
+        std::free(ptr);
+    }
+
+
+    void
+    report_memory(std::string_view name, std::size_t bytes)
+    {
+        io::println("{:<40} {:>10} B", name, bytes);
+    }
+
+
+    [[nodiscard]]
+    auto
+    count_substitutions(const parser::TokenGroup &group) -> std::size_t
+    {
+        std::size_t count { 0 };
+        for (const parser::TokenType type : group.tokens.get_types())
+            count += type == parser::TokenType::SUB_BRACKET ? 1 : 0;
+        return count;
+    }
+}
+
+
+/* counted so that the memory held by a tree can be reported */
+auto
+operator new(std::size_t size) -> void *
+{
+    return track(std::malloc(size));
+}
+
+
+auto
+operator new(std::size_t size, std::align_val_t align) -> void *
+{
+    const auto alignment { static_cast<std::size_t>(align) };
+    return track(std::aligned_alloc(
+        alignment, (size + alignment - 1) / alignment * alignment));
+}
+
+
+void
+operator delete(void *ptr) noexcept
+{
+    untrack(ptr);
+}
+
+
+void
+operator delete(void *ptr, std::size_t /* size */) noexcept
+{
+    untrack(ptr);
+}
+
+
+void
+operator delete(void *ptr, std::align_val_t /* align */) noexcept
+{
+    untrack(ptr);
+}
+
+
+void
+operator delete(void *ptr,
+                std::size_t /* size */,
+                std::align_val_t /* align */) noexcept
+{
+    untrack(ptr);
+}
+
+
+auto
+main() -> int
+{
+    const std::string small { R"(ls -la --color=auto "some dir" { pwd } x)" };
+
+    std::string large { "echo" };
+    for (std::size_t i { 0 }; i < STEP_COUNT; i++)
+        large += R"( { a } -f "s" x -abc --long=v {{ 1 + 2 }})";
+
+    /* the trees are kept alive, so that only what they hold is counted */
+    std::vector<parser::shared_tokens> trees;
+    trees.reserve(SMALL_TREE_COUNT);
+
+    const std::size_t before_small { LIVE_BYTES };
+    for (std::size_t i { 0 }; i < SMALL_TREE_COUNT; i++)
+        trees.push_back(parser::parse("benchmark", small));
+    report_memory("small statement tree",
+                  (LIVE_BYTES - before_small) / SMALL_TREE_COUNT);
+
+    const std::size_t before_large { LIVE_BYTES };
+    const auto        tokens { parser::parse("benchmark", large) };
+    report_memory("large statement tree", LIVE_BYTES - before_large);
+    trees.clear();
+
+    io::println("{} top-level tokens", tokens->tokens.size());
+
+    bench::report("parse large statement",
+                  bench::measure(RUNS, [&]() -> void
+                                 { bench::keep(parser::parse("benchmark",
+                                                             large)); }));
+
+    bench::report(std::format("scan token types {} times", SCANS_PER_RUN),
+                  bench::measure(RUNS, [&]() -> void
+                                 {
+                                     for (std::size_t i { 0 };
+                                          i < SCANS_PER_RUN; i++)
+                                         bench::keep(
+                                             count_substitutions(*tokens));
+                                 }));
+
+    return 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+
+namespace cmd
+{
+    /**
+     * a BK-tree of names, used to find every name within a small
+     * edit distance of a misspelled one
+     * ----------------------------------------------------------
+     *
+     * the tree does not own the names, each node stores the offset and
+     * length of its name inside a buffer that is passed on every call,
+     * so the tree stays valid when the buffer is copied or reallocated
+     */
+    class FuzzyIndex
+    {
+    public:
+        struct Match
+        {
+            std::uint32_t offset;
+            std::uint16_t length;
+            int           distance;
+        };
+
+
+        /**
+         * adds the name at @p offset inside @p buffer to the tree,
+         * or revives it if it was removed before
+         */
+        void insert(std::string_view buffer,
+                    std::uint32_t    offset,
+                    std::uint16_t    length);
+
+
+        /**
+         * removes @p name from the tree, the node is kept as a tombstone
+         * since BK-tree nodes can not be unlinked from their children
+         */
+        void erase(std::string_view buffer, std::string_view name);
+
+
+        /**
+         * get every name within @p max_distance of @p name
+         */
+        [[nodiscard]]
+        auto find(std::string_view buffer,
+                  std::string_view name,
+                  int              max_distance) const -> std::vector<Match>;
+
+    private:
+        static constexpr std::uint32_t NONE { UINT32_MAX };
+
+
+        struct Node
+        {
+            std::uint32_t offset;
+            std::uint16_t length;
+
+            /* the distance between this node and its parent */
+            std::uint8_t distance;
+            bool         alive;
+
+            std::uint32_t first_child;
+            std::uint32_t next_sibling;
+        };
+
+        std::vector<Node> m_nodes;
+
+
+        /**
+         * walks down the tree, calling @p on_node on each node that
+         * may be within @p max_distance of @p name
+         */
+        template <typename T_Func>
+        void walk(std::string_view buffer,
+                  std::string_view name,
+                  int              max_distance,
+                  T_Func         &&on_node) const;
+    };
+}
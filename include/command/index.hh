@@ -0,0 +1,106 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <sys/stat.h>
+
+
+namespace cmd
+{
+    /**
+     * a persistent, memory-mapped index of the executables inside
+     * each $PATH directory
+     * -----------------------------------------------------------
+     *
+     * every directory is stored along with its device, inode and
+     * modification time, a directory is only rescanned when one of
+     * those no longer matches the directory on disk
+     */
+    class Index
+    {
+    public:
+        /**
+         * maps the index stored at @p file , a missing or corrupted
+         * file is treated as an empty index
+         */
+        Index(std::filesystem::path file);
+        ~Index();
+
+        Index(const Index &)                     = delete;
+        auto operator=(const Index &) -> Index & = delete;
+
+
+        /**
+         * get the cached executable names inside @p dir
+         * ---------------------------------------------
+         *
+         * the names are returned as a single buffer where each name is
+         * terminated by a null byte, @p info must be the stat of @p dir
+         *
+         * the function returns std::nullopt if the directory has no record,
+         * or if the record is stale, the returned view is valid for as long
+         * as the index is alive
+         */
+        [[nodiscard]]
+        auto find(const std::string &dir, const struct stat &info)
+            -> std::optional<std::string_view>;
+
+
+        /**
+         * stores the freshly scanned @p names of @p dir , replacing
+         * its stale record, the names must be formatted like the
+         * ones returned by @e find
+         */
+        auto insert(const std::string &dir,
+                    const struct stat &info,
+                    std::string        names) -> std::string_view;
+
+
+        /**
+         * writes the directories requested through @e find and @e insert
+         * back to disk, the function does nothing if none of them changed
+         */
+        void save();
+
+    private:
+        struct Record
+        {
+            std::string_view path;
+            std::string_view names;
+
+            std::uint64_t device;
+            std::uint64_t inode;
+            std::int64_t  mtime_sec;
+            std::int64_t  mtime_nsec;
+
+
+            /**
+             * backing storage for @e path and @e names
+             * when the record does not come from the mapped file
+             */
+            std::shared_ptr<const std::string> storage;
+
+
+            [[nodiscard]]
+            auto matches(const struct stat &info) const -> bool;
+        };
+
+        std::filesystem::path m_file;
+
+        const char *m_data;
+        std::size_t m_size;
+
+        std::vector<Record> m_records;
+        std::vector<Record> m_requested;
+        bool                m_dirty;
+
+
+        [[nodiscard]]
+        auto load() -> bool;
+    };
+}
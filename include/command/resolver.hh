@@ -0,0 +1,123 @@
+#pragma once
+#include <filesystem>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <sys/stat.h>
+
+
+namespace cmd
+{
+    /**
+     * resolves commands on demand, much like the hash table of bash
+     * -------------------------------------------------------------
+     *
+     * a command is looked up in each directory in order the first time
+     * it is requested, both found and missing commands are cached
+     *
+     * a cached answer is dropped once the modification time of one of the
+     * directories it depends on changes, which are all directories before
+     * and including the one the command was found in, or every directory
+     * for a command that was not found
+     *
+     * a directory that was missing when the resolver was created, or that
+     * was removed and created again, is reopened before a command is
+     * reported as missing
+     */
+    class Resolver
+    {
+    public:
+        /**
+         * opens a handle to every directory of @p dirs
+         */
+        Resolver(const std::vector<std::string> &dirs);
+        ~Resolver();
+
+        Resolver(const Resolver &)                     = delete;
+        auto operator=(const Resolver &) -> Resolver & = delete;
+
+
+        /**
+         * get the full path of the executable named @p name ,
+         * or std::nullopt if it is not in any of the directories
+         */
+        [[nodiscard]]
+        auto resolve(std::string_view name)
+            -> std::optional<std::filesystem::path>;
+
+    private:
+        struct Directory
+        {
+            std::string path;
+            int         fd;
+            timespec    mtime;
+            dev_t       device;
+            ino_t       inode;
+        };
+
+
+        struct StringHash
+        {
+            using is_transparent = void;
+
+
+            [[nodiscard]]
+            auto
+            operator()(std::string_view str) const -> std::size_t
+            {
+                return std::hash<std::string_view> {}(str);
+            }
+        };
+
+        static constexpr std::size_t NOT_FOUND {
+            std::numeric_limits<std::size_t>::max()
+        };
+
+        std::mutex             m_mutex;
+        std::vector<Directory> m_directories;
+
+        /* maps a command to the index of the directory it was found in */
+        std::unordered_map<std::string, std::size_t, StringHash,
+                           std::equal_to<>>
+            m_cache;
+
+
+        /**
+         * opens a handle to the directory at @p path ,
+         * with a negative fd if it can not be opened
+         */
+        [[nodiscard]]
+        static auto open_directory(const std::string &path) -> Directory;
+
+
+        /**
+         * drops every cached answer that depends on the directory
+         * at index @p first
+         */
+        void invalidate_from(std::size_t first);
+
+
+        /**
+         * checks the directories up to @p last (inclusive) for changes,
+         * and drops every cached answer that depends on a changed one
+         */
+        void invalidate_changed(std::size_t last);
+
+
+        /**
+         * reopens every directory that is missing or no longer the one
+         * at its path, and drops every cached answer that depends on one,
+         * returns whether any directory was reopened
+         */
+        auto reopen_replaced() -> bool;
+
+
+        [[nodiscard]]
+        auto lookup(std::string_view name) const -> std::size_t;
+    };
+}
@@ -1,14 +1,70 @@
 #pragma once
-#include <filesystem>
-#include <string>
-#include <unordered_map>
+#include <cstdint>
+#include <memory>
+
+#include "command/table.hh"
 
 
 namespace cmd
 {
-    inline std::unordered_map<std::string, std::filesystem::path>
-        BINARY_PATH_LIST;
+    enum class Resolution : std::uint8_t
+    {
+        /* every $PATH directory is scanned up front */
+        SCAN,
+
+        /* commands are looked up the first time they are needed */
+        LAZY,
+    };
+
+
+    /**
+     * starts filling the binary path list on a background thread
+     * ----------------------------------------------------------
+     *
+     * the function returns immediately, the result is published
+     * once the scan is done and can be read with get_binary_path_list()
+     *
+     * once filled, the list is kept up to date by watching
+     * every $PATH directory for changes
+     */
+    void start_binary_path_scan();
+
+
+    /**
+     * get a snapshot of the list of executables found in $PATH
+     * --------------------------------------------------------
+     *
+     * the snapshot is immutable, updates are published as a new snapshot
+     * so holding on to one never blocks the updates nor other readers
+     *
+     * the function only blocks if the first snapshot is not published yet,
+     * if no scan was started, the function will start one and wait for it
+     */
+    [[nodiscard]]
+    auto get_binary_path_list() -> std::shared_ptr<const Table>;
+
+
+    /**
+     * get the number of binary path list snapshots published so far,
+     * anything derived from a snapshot is stale once this changes
+     */
+    [[nodiscard]]
+    auto get_binary_path_generation() -> std::uint64_t;
+
+
+    /**
+     * sets how binary_exists() resolves commands, defaults to SCAN
+     */
+    void set_resolution(Resolution resolution);
 
 
-    void fill_binary_path_list();
+    /**
+     * checks whether an executable named @p name exists in $PATH
+     * ----------------------------------------------------------
+     *
+     * with Resolution::SCAN this waits for the binary path list,
+     * with Resolution::LAZY only the requested command is looked up
+     */
+    [[nodiscard]]
+    auto binary_exists(std::string_view name) -> bool;
 }
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <vector>
+
+
+namespace cmd
+{
+    /**
+     * reads the names of the executables directly inside @p dir
+     * ----------------------------------------------------------
+     *
+     * the directory is not scanned recursively, the names are returned
+     * as a single buffer where each name is terminated by a null byte
+     *
+     * the type of each entry is taken from the directory listing itself,
+     * an entry is only stat-ed if it is a symlink or its type is unknown
+     */
+    [[nodiscard]]
+    auto scan_directory(const std::string &dir) -> std::string;
+
+
+    /**
+     * runs scan_directory() on every directory of @p dirs
+     * ---------------------------------------------------
+     *
+     * the directories are scanned in parallel on a small pool of threads,
+     * the n-th result belongs to the n-th directory of @p dirs
+     */
+    [[nodiscard]]
+    auto scan_directories(const std::vector<std::string> &dirs)
+        -> std::vector<std::string>;
+}
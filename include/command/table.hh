@@ -0,0 +1,131 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "command/fuzzy_index.hh"
+
+
+namespace cmd
+{
+    /**
+     * a flat table of executables and the directory they are found in
+     * ---------------------------------------------------------------
+     *
+     * every directory and every name is stored once inside a single
+     * contiguous buffer, the entries only hold offsets into it and are
+     * kept sorted by name, so lookups never allocate
+     */
+    class Table
+    {
+    public:
+        using dir_id = std::uint16_t;
+
+
+        struct Entry
+        {
+            std::uint32_t name_offset;
+            std::uint16_t name_length;
+            dir_id        directory;
+        };
+
+
+        /**
+         * a directory and the names of the executables inside it,
+         * each name terminated by a null byte
+         */
+        using directory_names = std::pair<std::string_view, std::string_view>;
+
+
+        Table() = default;
+
+
+        /**
+         * builds a table from @p dirs
+         * ---------------------------
+         *
+         * the directory ids are the indices of @p dirs , if a name is
+         * found in several directories, the first directory wins
+         */
+        Table(const std::vector<directory_names> &dirs);
+
+
+        /**
+         * get the entry named @p name , or nullptr if there is none
+         */
+        [[nodiscard]]
+        auto find(std::string_view name) const -> const Entry *;
+
+
+        [[nodiscard]]
+        auto contains(std::string_view name) const -> bool;
+
+
+        /**
+         * get every name within @p max_distance edits of @p name ,
+         * along with its distance
+         */
+        [[nodiscard]]
+        auto find_similar(std::string_view name, int max_distance) const
+            -> std::vector<std::pair<std::string_view, int>>;
+
+
+        /**
+         * adds @p name to the table, or moves it to @p dir if it exists
+         */
+        void set(std::string_view name, dir_id dir);
+
+
+        /**
+         * removes @p name from the table, the function does nothing
+         * if @p name does not exist
+         */
+        void erase(std::string_view name);
+
+
+        [[nodiscard]]
+        auto get_name(const Entry &entry) const -> std::string_view;
+
+
+        [[nodiscard]]
+        auto get_directory(const Entry &entry) const -> std::string_view;
+
+
+        /**
+         * get the full path of the executable of @p entry
+         */
+        [[nodiscard]]
+        auto get_path(const Entry &entry) const -> std::filesystem::path;
+
+
+        [[nodiscard]]
+        auto size() const -> std::size_t;
+
+
+        [[nodiscard]]
+        auto begin() const -> std::vector<Entry>::const_iterator;
+
+
+        [[nodiscard]]
+        auto end() const -> std::vector<Entry>::const_iterator;
+
+    private:
+        struct Directory
+        {
+            std::uint32_t offset;
+            std::uint32_t length;
+        };
+
+        std::string            m_buffer;
+        std::vector<Directory> m_directories;
+        std::vector<Entry>     m_entries;
+        FuzzyIndex             m_fuzzy_index;
+
+
+        [[nodiscard]]
+        auto lower_bound(std::string_view name) const
+            -> std::vector<Entry>::const_iterator;
+    };
+}
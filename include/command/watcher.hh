@@ -0,0 +1,148 @@
+#pragma once
+#include <functional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+
+namespace cmd
+{
+    /**
+     * watches a list of directories for entries being added,
+     * removed, renamed or having their permission changed
+     */
+    class Watcher
+    {
+    public:
+        /**
+         * a change to the entry @p name of the directory at @p dir_idx
+         * inside the directory list
+         * -----------------------------------------------------------
+         *
+         * an empty name means the directory itself changed, or that
+         * events were lost, so every entry of it should be revalidated,
+         * in the latter case the directory index will be npos
+         *
+         * a directory that is created, or deleted and created again,
+         * after the watcher was made also gives an empty name once it
+         * is watched, so that the entries already inside it are read
+         */
+        struct Change
+        {
+            std::size_t      dir_idx;
+            std::string_view name;
+        };
+
+
+        /**
+         * the callback receives the changes of a burst of events at
+         * once, the names are only valid during the call
+         */
+        using callback = std::function<void(std::span<const Change> changes)>;
+
+
+        /**
+         * adds a watch on every directory of @p dirs
+         * ------------------------------------------
+         *
+         * events are queued from this point on, but @p on_change
+         * will only be called after start() is called
+         *
+         * a directory that does not exist is watched through its closest
+         * existing parent instead, until it is created
+         */
+        Watcher(const std::vector<std::string> &dirs, callback on_change);
+        ~Watcher();
+
+        Watcher(const Watcher &)                     = delete;
+        auto operator=(const Watcher &) -> Watcher & = delete;
+
+
+        /**
+         * starts dispatching the queued events on a background thread
+         */
+        void start();
+
+    private:
+        using watch = std::pair<int, std::size_t>;
+
+
+        /* a queued change, its name is kept inside m_names , since the
+           buffer the events are read into is reused */
+        struct PendingChange
+        {
+            std::size_t dir_idx;
+            std::size_t name_offset;
+            std::size_t name_length;
+        };
+
+
+        int m_fd;
+        int m_wake_fd;
+
+        std::vector<std::string> m_dirs;
+
+        /* maps the inotify watch descriptors to the directory index */
+        std::vector<watch> m_watches;
+
+        /* maps the watch descriptors of the parents of the directories
+           that do not exist to the index of those directories */
+        std::vector<watch> m_parent_watches;
+
+        /* the changes gathered for the next batch */
+        std::vector<PendingChange> m_pending;
+        std::string                m_names;
+
+        callback    m_on_change;
+        std::thread m_thread;
+
+
+        /**
+         * watches the directory at @p dir_idx , or its closest existing
+         * parent if it does not exist, returns whether the directory
+         * itself is watched
+         */
+        auto add_watch(std::size_t dir_idx) -> bool;
+
+
+        /**
+         * removes the watch of @p wd once no directory uses it anymore
+         */
+        void release_watch(int wd);
+
+
+        /**
+         * handles an event on the parent of missing directories,
+         * watching the ones that were created
+         */
+        void on_parent_event(int wd);
+
+
+        /**
+         * handles the directories watched by @p wd being deleted or
+         * moved away, watching them again if they already came back
+         */
+        void on_directory_gone(int wd, std::uint32_t mask);
+
+
+        void queue(std::size_t dir_idx, std::string_view name);
+
+
+        /**
+         * reads the pending events and queues their changes,
+         * returns false once the inotify descriptor is unusable
+         */
+        auto read_events() -> bool;
+
+
+        /**
+         * calls the callback with every queued change
+         */
+        void dispatch();
+
+
+        void run();
+    };
+}
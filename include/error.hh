@@ -99,6 +99,20 @@ namespace error
                                std::size_t        len);
 
 
+        /**
+         * specify the error context, with the line and the column of the
+         * error in @p text already known
+         *
+         * @p first_line is the line of @p input_source that @p text
+         * starts at, for text taken from the middle of a file
+         */
+        void set_error_context(const std::string      &input_source,
+                               const std::string      &text,
+                               std::spair<std::size_t> pos,
+                               std::size_t             len,
+                               std::size_t             first_line = 0);
+
+
         /**
          * creates a formatted pretty message containing the error
          * -------------------------------------------------------
@@ -109,6 +123,10 @@ namespace error
         [[nodiscard]]
         auto create_pretty_message(bool force = false) -> std::string;
 
+
+        [[nodiscard]]
+        auto get_error_type() const -> std::string_view;
+
     private:
         std::string m_error_type;
         std::string m_pretty_msg;
@@ -118,6 +136,7 @@ namespace error
         std::string              m_input_source;
         std::spair<std::size_t>  m_error_pos;
         std::size_t              m_error_len;
+        std::size_t              m_first_line { 0 };
     };
 
 
@@ -3,6 +3,8 @@
 #include <optional>
 #include <vector>
 
+#include "string_pool.hh"
+
 
 namespace history
 {
@@ -58,9 +60,11 @@ namespace history
     private:
         std::filesystem::path m_history_file;
 
-        std::vector<std::string> m_lines;
-        std::size_t              m_idx;
-        bool                     m_first_run;
+        /* the lines are kept in the session's string pool, so a line
+           entered many times is only stored once */
+        std::vector<utils::StringPool::id> m_lines;
+        std::size_t                        m_idx;
+        bool                               m_first_run;
 
 
         [[nodiscard]]
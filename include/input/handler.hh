@@ -34,6 +34,14 @@ namespace input
         auto should_exit() const -> bool;
 
 
+        /**
+         * get the tokens of @p str , the line that was just read, when
+         * they were kept up to date while it was typed, or nullptr
+         */
+        [[nodiscard]]
+        auto take_tokens(const std::string &str) -> parser::shared_tokens;
+
+
     private:
         std::istream *m_stream;
         bool          m_exit;
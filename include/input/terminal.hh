@@ -6,6 +6,7 @@
 
 #include "history/history.hh"
 #include "input/cursor.hh"
+#include "parser/parser.hh"
 
 
 namespace input::term
@@ -42,6 +43,15 @@ namespace input::term
         [[nodiscard]]
         auto is_active() const -> bool;
 
+
+        /**
+         * get the tokens of @p str , the line that was just read, which
+         * are kept up to date while it is edited, or nullptr if they are
+         * not known
+         */
+        [[nodiscard]]
+        auto take_tokens(const std::string &str) -> parser::shared_tokens;
+
     private:
         static Handler *m_handler_instance;
 
@@ -62,6 +72,15 @@ namespace input::term
         termios m_old_term;
         bool    m_is_term;
 
+        /* the tokens of the line being edited, reparsed after every edit */
+        parser::shared_tokens m_tokens;
+
+
+        /**
+         * updates @e m_tokens after @p edit was applied to @p str
+         */
+        void update_tokens(const std::string &str, const parser::Edit &edit);
+
 
         void insert_char_to_cursor(std::string &str, unsigned char c);
 
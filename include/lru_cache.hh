@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+
+namespace utils
+{
+    /**
+     * a map that holds at most a fixed number of entries
+     * --------------------------------------------------
+     *
+     * once full, inserting a new key evicts the entry that was
+     * looked up or inserted the longest time ago
+     */
+    template <typename T_Key, typename T_Value>
+    class LruCache
+    {
+    public:
+        LruCache(std::size_t capacity) : m_capacity(capacity) {}
+
+
+        /**
+         * get the value of @p key and mark it as the most recently used,
+         * or nullptr if there is none
+         *
+         * the pointer is invalidated by the next call to insert()
+         */
+        [[nodiscard]]
+        auto
+        find(const T_Key &key) -> T_Value *
+        {
+            auto it { m_map.find(key) };
+            if (it == m_map.end()) return nullptr;
+
+            m_entries.splice(m_entries.begin(), m_entries, it->second);
+            return &it->second->second;
+        }
+
+
+        /**
+         * sets the value of @p key , evicting the least recently used
+         * entry if the cache is full
+         */
+        void
+        insert(const T_Key &key, T_Value value)
+        {
+            if (auto it { m_map.find(key) }; it != m_map.end())
+            {
+                it->second->second = std::move(value);
+                m_entries.splice(m_entries.begin(), m_entries, it->second);
+                return;
+            }
+
+            if (m_capacity == 0) return;
+
+            if (m_map.size() >= m_capacity)
+            {
+                m_map.erase(m_entries.back().first);
+                m_entries.pop_back();
+            }
+
+            m_entries.emplace_front(key, std::move(value));
+            m_map.emplace(key, m_entries.begin());
+        }
+
+
+        void
+        erase(const T_Key &key)
+        {
+            auto it { m_map.find(key) };
+            if (it == m_map.end()) return;
+
+            m_entries.erase(it->second);
+            m_map.erase(it);
+        }
+
+
+        void
+        clear()
+        {
+            m_map.clear();
+            m_entries.clear();
+        }
+
+
+        [[nodiscard]]
+        auto
+        size() const -> std::size_t
+        {
+            return m_map.size();
+        }
+
+    private:
+        using entry_list = std::list<std::pair<T_Key, T_Value>>;
+
+        std::size_t m_capacity;
+
+        /* the most recently used entry comes first */
+        entry_list                                               m_entries;
+        std::unordered_map<T_Key, typename entry_list::iterator> m_map;
+    };
+}
@@ -1,5 +1,4 @@
 #pragma once
-#include <algorithm>
 #include <cstdint>
 #include <string>
 
@@ -82,42 +81,26 @@ namespace parser
         }
 
 
-        [[nodiscard]]
-        auto compute_real_index(const TokenGroup *group, const Token *tkn)
-            -> std::size_t;
-
-
         template <Type T_ErrorType, typename... T_Args>
         [[nodiscard]]
         auto
-        create(TokenGroup      &tokens,
-               Token           &token,
-               std::string_view fmt,
+        create(const TokenGroup &tokens,
+               const Token      &token,
+               std::string_view  fmt,
                T_Args &&...args) -> ::error::Info
         {
             ::error::Info err { std::string { type_to_string(T_ErrorType) },
                                 fmt, std::forward<T_Args>(args)... };
 
-            auto it { std::ranges::find(tokens.tokens, token) };
-            if (it == tokens.tokens.end()) return err;
-
             const auto *toplevel { tokens.get_toplevel() };
-            std::string text;
-            try
-            {
-                if (const auto *str_ptr { token.get_data<std::string>() })
-                    text = *str_ptr;
-                else
-                    text = "[NO DATA]";
-            }
-            catch (const std::bad_variant_access &)
-            {
-                text = "[NO DATA]";
-            }
-
-            err.set_error_context(tokens.source, toplevel->raw,
-                                  compute_real_index(&tokens, &token),
-                                  text.length());
+            const std::string_view text { token.get_text().value_or(
+                "[NO DATA]") };
+
+            /* the position was recorded while parsing */
+            err.set_error_context(
+                std::string { tokens.source }, std::string { toplevel->raw },
+                { token.position.line, token.position.column }, text.length(),
+                toplevel->tree->get_first_line());
             return err;
         }
     }
@@ -0,0 +1,26 @@
+#pragma once
+#include <string_view>
+#include <vector>
+
+#include "../error.hh"
+
+
+namespace parser
+{
+    /**
+     * checks the syntax of every statement of @p script
+     * -------------------------------------------------
+     *
+     * the statements are found with a single StatementScanner pass, then
+     * parsed and verified in batches on a pool of threads, without asking
+     * to correct anything
+     *
+     * @p thread_count of 0 uses every core, the errors are returned in
+     * the order of the statements they were found in
+     */
+    [[nodiscard]]
+    auto lint_script(std::string_view script,
+                     std::string_view source,
+                     std::size_t      thread_count = 0)
+        -> std::vector<::error::Info>;
+}
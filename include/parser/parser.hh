@@ -1,9 +1,22 @@
 #pragma once
+#include <memory>
+
 #include "parser/types.hh"
 
 
 namespace parser
 {
+    /**
+     * replaces @e removed bytes at @e offset of a text with @e inserted
+     */
+    struct Edit
+    {
+        std::size_t      offset;
+        std::size_t      removed;
+        std::string_view inserted;
+    };
+
+
     /**
      * parses text into a bunch of tokens, this function will never throw
      * ------------------------------------------------------------------
@@ -47,9 +60,72 @@ namespace parser
      *  - TokenType::STRING_CONTENT
      *      the parser will treat any sentence after a '"' and before a second
      *    '"' as a string content
+     *
+     * @p first_line is the line of @p input_source that @p text starts at,
+     * so that the errors of a statement point into the whole script
+     */
+    [[nodiscard]]
+    auto parse(std::string_view   input_source,
+               const std::string &text,
+               std::size_t        first_line = 0) noexcept -> shared_tokens;
+
+
+    /**
+     * parses the text of @p previous with @p edit applied to it
+     * ---------------------------------------------------------
+     *
+     * only the steps of the parser that touch the edit are tokenized
+     * again, the columns of the tokens before and after them are copied
+     * as a whole, the ones after being shifted by the change in length,
+     * and the groups they hold are shared with @p previous until either
+     * tree changes them
+     *
+     * an edit that adds or removes a quote or a bracket changes how the
+     * rest of the text is split, so everything after it is tokenized again
+     *
+     * the new tree keeps the trees it shares groups with alive, a text
+     * edited many times in a row is parsed from scratch once in a while
+     * so that it does not keep all of them
+     *
+     * @p previous must be a top-level group returned by parse() or reparse()
+     */
+    [[nodiscard]]
+    auto reparse(const shared_tokens &previous, const Edit &edit) noexcept
+        -> shared_tokens;
+
+
+    /* the longest text parse_cached() keeps the tokens of */
+    constexpr std::size_t MAX_CACHED_LENGTH { 4096 };
+
+
+    /**
+     * a statement parsed by parse_cached()
+     */
+    struct CachedStatement
+    {
+        /* shared with every other caller that parsed the same text, so
+           it must not be changed, verify it with verify_syntax(false,
+           syntax) or parse it again to correct it */
+        shared_tokens tokens;
+
+        SyntaxCheck syntax;
+    };
+
+
+    /**
+     * parses @p text , reusing the tokens of the last time the same text
+     * was parsed from @p input_source
+     * ------------------------------------------------------------------
+     *
+     * the statements are kept in a bounded cache keyed by their content,
+     * evicting the least recently used one, along with the result of
+     * TokenGroup::check_syntax() for them, which only depends on the
+     * text, a hit neither lexes nor checks the syntax again
+     *
+     * texts longer than MAX_CACHED_LENGTH are parsed without being cached
      */
     [[nodiscard]]
-    auto parse(std::string          input_source,
-               const std::string   &text,
-               const shared_tokens &parent = nullptr) noexcept -> shared_tokens;
+    auto parse_cached(std::string_view   input_source,
+                      const std::string &text) noexcept
+        -> std::shared_ptr<const CachedStatement>;
 }
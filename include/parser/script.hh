@@ -0,0 +1,135 @@
+#pragma once
+#include <cstddef>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "parser/types.hh"
+
+
+namespace parser
+{
+    /**
+     * finds the ends of the top-level statements of a script
+     * -------------------------------------------------------
+     *
+     * a statement ends at a newline that is not inside a string or a
+     * substitution and does not follow a backslash, the quotes and the
+     * brackets are counted the same way the parser counts them
+     *
+     * the script can be fed in chunks of any size, the state is kept
+     * from one chunk to the next until a statement ends
+     */
+    class StatementScanner
+    {
+    public:
+        /**
+         * get the position of the newline ending the current statement
+         * inside @p chunk , or npos if it goes on past the chunk
+         *
+         * @p previous is the character before @p chunk , or a null
+         * byte at the start of the statement
+         */
+        [[nodiscard]]
+        auto find_end(std::string_view chunk, char previous) -> std::size_t;
+
+    private:
+        bool        m_in_string { false };
+        std::size_t m_depth { 0 };
+    };
+
+
+    /**
+     * get the text of every top-level statement of @p script , found
+     * by a StatementScanner, statements with nothing but whitespace
+     * are skipped
+     */
+    [[nodiscard]]
+    auto split_statements(std::string_view script)
+        -> std::vector<std::string_view>;
+
+
+    /**
+     * finds the lines of positions inside a text, counting the newlines
+     * from the last position asked for, so that asking for the positions
+     * in order reads the text only once
+     */
+    class LineCounter
+    {
+    public:
+        explicit LineCounter(std::string_view text);
+
+
+        /**
+         * get the line (starting from 0) that the byte at @p pos is on
+         */
+        [[nodiscard]]
+        auto get_line(std::size_t pos) -> std::size_t;
+
+    private:
+        std::string_view m_text;
+        std::size_t      m_pos { 0 };
+        std::size_t      m_line { 0 };
+    };
+
+
+    /**
+     * splits a script into statements while reading it
+     * -------------------------------------------------
+     *
+     * the script is read through a window of a fixed size, and every
+     * statement is parsed as soon as it is closed, so the memory used
+     * depends on the longest statement instead of the whole script
+     *
+     * the statements are found by a StatementScanner, so they are the
+     * same no matter where the window boundaries fall
+     */
+    class ScriptReader
+    {
+    public:
+        static constexpr std::size_t DEFAULT_WINDOW_SIZE { 64 * 1024 };
+
+
+        /**
+         * reads the script from @p stream , which is not owned by the
+         * reader, @p source is the name the statements are parsed under
+         */
+        ScriptReader(std::istream    &stream,
+                     std::string_view source,
+                     std::size_t      window_size = DEFAULT_WINDOW_SIZE);
+
+
+        /**
+         * parses the next statement of the script, or returns nullptr
+         * once every statement has been read
+         *
+         * statements with nothing but whitespace are skipped
+         */
+        [[nodiscard]]
+        auto next() -> shared_tokens;
+
+    private:
+        std::istream *m_stream;
+        std::string   m_source;
+
+        std::vector<char> m_window;
+        std::size_t       m_window_pos;
+        std::size_t       m_window_end;
+
+        /* the part of the statement read so far, kept between
+           statements so that its buffer is reused */
+        std::string m_statement;
+
+        /* the line the next statement starts at */
+        std::size_t m_line;
+
+
+        /**
+         * reads the next chunk of the script into the window,
+         * returns false at the end of the stream
+         */
+        [[nodiscard]]
+        auto fill_window() -> bool;
+    };
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "../error.hh"
+#include "parser/types.hh"
+
+
+namespace parser
+{
+    /**
+     * checks every statement of the script at @p path the way
+     * verify_syntax(false) does, reusing the tokens cached from the last
+     * time it was parsed
+     * -------------------------------------------------------------------
+     *
+     * the tokens are stored in a binary file inside the cache directory,
+     * named after @p path , holding offsets instead of pointers, the file
+     * is only used while the size, modification time and content hash of
+     * the script all match it, in which case it is mapped and the
+     * commands are checked straight from it, without lexing the script
+     * again, only the statements with an error get their token groups
+     * rebuilt, to create the error from
+     *
+     * a missing, stale or corrupted cache file is replaced after parsing
+     * the script, and no cache file is written if the cache directory
+     * cannot be used
+     *
+     * the errors are returned in the order of the statements they were
+     * found in, or std::nullopt if the script cannot be read
+     */
+    [[nodiscard]]
+    auto check_script(const std::filesystem::path &path)
+        -> std::optional<std::vector<::error::Info>>;
+}
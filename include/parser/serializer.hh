@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+#include "parser/types.hh"
+
+
+namespace parser
+{
+    enum class OutputFormat : std::uint8_t
+    {
+        JSON,
+        BINARY,
+    };
+
+
+    /**
+     * appends @p group to @p out as JSON
+     * -----------------------------------
+     *
+     * the text is the same, byte for byte, as Json::to_string() gives
+     * for TokenGroup::to_json(), but it is written straight from the
+     * tokens instead of building a Json::Value first
+     */
+    void write_json(const TokenGroup &group, std::string &out);
+
+
+    /**
+     * appends @p group to @p out in the binary format
+     * ------------------------------------------------
+     *
+     * a record is a 32-bit little-endian length followed by that many
+     * bytes holding the group, every other number is an unsigned LEB128
+     * varint:
+     *
+     *   group: length of raw, raw, token count, tokens
+     *   token: type (one byte, the value of TokenType), index, then the
+     *          group it holds for SUB_CONTENT, or length of text, text
+     *
+     * the records can be read one after the other from a stream
+     */
+    void write_binary(const TokenGroup &group, std::string &out);
+
+
+    /**
+     * appends @p group to @p out in @p format , JSON is followed by a
+     * newline, so that the statements of a stream can be told apart
+     */
+    void serialize(const TokenGroup &group,
+                   OutputFormat      format,
+                   std::string      &out);
+}
@@ -0,0 +1,102 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+
+
+namespace parser
+{
+    /**
+     * the positions of every structural character of a text
+     * ------------------------------------------------------
+     *
+     * the text is classified 64 bytes at a time in a single pass, with
+     * AVX2 or SSE2 where the CPU has them and a lookup table otherwise,
+     * into one bitmap per character class, so the lexer can jump to the
+     * next character it cares about instead of testing every byte
+     *
+     * the classes do not depend on the locale, bytes outside of ASCII
+     * never belong to one
+     */
+    class StructuralIndex
+    {
+    public:
+        enum Class : std::uint8_t
+        {
+            /* ' ', '\t', '\n', '\v', '\f' and '\r' */
+            WHITESPACE = 1 << 0,
+
+            /* '"' */
+            QUOTE = 1 << 1,
+
+            /* '{' */
+            OPEN_BRACKET = 1 << 2,
+
+            /* '}' */
+            CLOSE_BRACKET = 1 << 3,
+
+            /* '-', '!', '|', '&', ';' and ':' */
+            OPERATOR = 1 << 4,
+
+            /* '=' */
+            EQUALS = 1 << 5,
+
+            /* '\\' */
+            BACKSLASH = 1 << 6,
+
+            /* the characters that start a token on their own */
+            TOKEN = QUOTE | OPEN_BRACKET | OPERATOR,
+        };
+
+        static constexpr std::size_t CLASS_COUNT { 7 };
+
+        /* the number of characters covered by one bitmap */
+        static constexpr std::size_t BLOCK_SIZE { 64 };
+
+
+        StructuralIndex(std::string_view           text,
+                        std::pmr::memory_resource *arena
+                        = std::pmr::get_default_resource());
+
+
+        /**
+         * get the position of the first character within [ @p from ,
+         * @p to ) that belongs to any class of @p mask , or @p to
+         * if there is none
+         */
+        [[nodiscard]]
+        auto find(std::uint8_t mask, std::size_t from, std::size_t to) const
+            -> std::size_t;
+
+
+        /**
+         * get the position of the first character within [ @p from ,
+         * @p to ) that belongs to none of the classes of @p mask , or @p to
+         * if there is none
+         */
+        [[nodiscard]]
+        auto find_not(std::uint8_t mask,
+                      std::size_t  from,
+                      std::size_t  to) const -> std::size_t;
+
+    private:
+        /**
+         * a bitmap of BLOCK_SIZE characters for each class
+         */
+        struct Block
+        {
+            std::array<std::uint64_t, CLASS_COUNT> bits;
+        };
+
+        std::pmr::vector<Block> m_blocks;
+
+
+        template <bool T_Invert>
+        [[nodiscard]]
+        auto find_first(std::uint8_t mask,
+                        std::size_t  from,
+                        std::size_t  to) const -> std::size_t;
+    };
+}
@@ -1,11 +1,17 @@
 #pragma once
 #include <cstdint>
+#include <array>
+#include <memory>
+#include <memory_resource>
 #include <optional>
+#include <span>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
 #include "../error.hh"
+#include "../string_pool.hh"
 
 namespace Json { class Value; }
 
@@ -101,29 +107,432 @@ namespace parser
     class Error;
 
 
+    /**
+     * where a token starts inside the text of its top-level group,
+     * the line and the column are counted from 0
+     */
+    struct Position
+    {
+        std::size_t   offset;
+        std::uint32_t line;
+        std::uint32_t column;
+    };
+
+
+    struct TokenGroup;
+    class TokenTree;
+
+
+    /**
+     * the result of the checks of a TokenGroup that only depend on its
+     * tokens, and not on the commands or files they name
+     */
+    struct SyntaxCheck
+    {
+        std::optional<::error::Info> error;
+
+        /* the number of groups, in preorder, that verify_syntax() enters
+           before finding @e error , so all of them if there is none */
+        std::size_t entered_groups { 0 };
+    };
+
+
+    /**
+     * checks the command @p text the way verify_syntax(false) checks the
+     * first token of a group, without needing the group itself
+     *
+     * returns false if verify_syntax(false) would report an error
+     */
+    [[nodiscard]]
+    auto is_valid_command(std::string_view text) -> bool;
+
+
+    /**
+     * the tokens of a TokenGroup, stored as parallel columns
+     * ------------------------------------------------------
+     *
+     * each field of the tokens is kept in its own array inside the
+     * arena, so a pass that only looks at the types of the tokens
+     * reads one byte per token instead of a whole Token
+     *
+     * a text is stored as an offset and a length into the text the
+     * list was created with, the texts found nowhere in it and the
+     * groups held by the tokens go to sparse tables instead, which
+     * the offset of the token then indexes
+     *
+     * reading a token gives a Token put together from the columns,
+     * changes go through the methods of the list
+     */
+    class TokenList
+    {
+    public:
+        /**
+         * goes over the tokens of a list, giving a Token for each one
+         */
+        class Iterator
+        {
+        public:
+            using value_type      = Token;
+            using difference_type = std::ptrdiff_t;
+
+
+            Iterator(const TokenList *list, std::size_t idx);
+
+
+            [[nodiscard]]
+            auto operator*() const -> Token;
+
+            auto operator++() -> Iterator &;
+
+            [[nodiscard]]
+            auto operator==(const Iterator &other) const -> bool = default;
+
+        private:
+            const TokenList *m_list;
+            std::size_t      m_idx;
+        };
+
+
+        /* the size of the columns of one token */
+        static constexpr std::size_t TOKEN_SIZE {
+            sizeof(Position) + 3 * sizeof(std::uint32_t) + sizeof(TokenType)
+            + sizeof(std::uint8_t)
+        };
+
+
+        /**
+         * @p text is the text the tokens are mostly views into
+         */
+        TokenList(std::string_view text, std::pmr::memory_resource *arena);
+
+        TokenList(const TokenList &)                     = delete;
+        auto operator=(const TokenList &) -> TokenList & = delete;
+
+
+        [[nodiscard]]
+        auto size() const -> std::size_t;
+
+        [[nodiscard]]
+        auto empty() const -> bool;
+
+        void reserve(std::size_t count);
+
+
+        /**
+         * adds @p token at the end of the list, its text has to stay
+         * alive as long as the list does
+         */
+        void push_back(const Token &token);
+
+
+        /**
+         * adds the tokens [ @p first , @p last ) of @p other at the end of
+         * the list, with their indexes and the offsets of their texts into
+         * the text of the list moved by @p shift
+         *
+         * the columns are copied as a whole, the texts found nowhere in
+         * the text of the list are copied into the arena, the groups held
+         * by the tokens are the ones of @p other
+         */
+        void append(const TokenList &other,
+                    std::size_t      first,
+                    std::size_t      last,
+                    std::ptrdiff_t   shift);
+
+
+        /**
+         * makes this empty list hold the same tokens as @p other , reading
+         * them from the columns of @p other until the list is changed,
+         * which first copies them into the arena of the list
+         *
+         * the text of the list must hold the same characters as the text
+         * of @p other
+         */
+        void share(const TokenList &other);
+
+
+        template <typename... T_Args>
+        void
+        emplace_back(T_Args &&...args)
+        {
+            push_back(Token(std::forward<T_Args>(args)...));
+        }
+
+
+        /**
+         * get a copy of the token at @p idx
+         */
+        [[nodiscard]]
+        auto operator[](std::size_t idx) const -> Token;
+
+        [[nodiscard]]
+        auto front() const -> Token;
+
+        [[nodiscard]]
+        auto begin() const -> Iterator;
+
+        [[nodiscard]]
+        auto end() const -> Iterator;
+
+
+        [[nodiscard]]
+        auto get_type(std::size_t idx) const -> TokenType;
+
+        [[nodiscard]]
+        auto get_index(std::size_t idx) const -> std::size_t;
+
+        [[nodiscard]]
+        auto starts_step(std::size_t idx) const -> bool;
+
+
+        /**
+         * get the text of the token at @p idx , or std::nullopt if
+         * it holds a token group
+         */
+        [[nodiscard]]
+        auto get_text(std::size_t idx) const -> std::optional<std::string_view>;
+
+
+        /**
+         * get the group held by the token at @p idx , or nullptr if
+         * it holds a text
+         */
+        [[nodiscard]]
+        auto get_group(std::size_t idx) const -> TokenGroup *;
+
+
+        /**
+         * get the id of the text of the token at @p idx in the session's
+         * string pool, or std::nullopt if it was not taken from there
+         */
+        [[nodiscard]]
+        auto get_text_id(std::size_t idx) const
+            -> std::optional<utils::StringPool::id>;
+
+
+        [[nodiscard]]
+        auto get_types() const -> std::span<const TokenType>;
+
+        [[nodiscard]]
+        auto get_indexes() const -> std::span<const std::uint32_t>;
+
+        [[nodiscard]]
+        auto get_positions() const -> std::span<const Position>;
+
+
+        /**
+         * get the length of the text of every token, 0 for the tokens
+         * that hold a group
+         */
+        [[nodiscard]]
+        auto get_lengths() const -> std::span<const std::uint32_t>;
+
+
+        void set_starts_step(std::size_t idx);
+
+        void set_position(std::size_t idx, const Position &position);
+
+
+        /**
+         * sets the text of the token at @p idx to @p text , which has
+         * to stay alive as long as the list does
+         */
+        void set_text(std::size_t idx, std::string_view text);
+
+
+        /**
+         * records that the text of the token at @p idx is @p text_id in
+         * the session's string pool, until the text is changed
+         */
+        void set_text_id(std::size_t idx, utils::StringPool::id text_id);
+
+
+        /**
+         * sets the group held by the token at @p idx , which has to hold
+         * one already, to @p group
+         */
+        void set_group(std::size_t idx, TokenGroup *group);
+
+
+        [[nodiscard]]
+        auto get_allocator() const -> std::pmr::polymorphic_allocator<>;
+
+    private:
+        enum Flag : std::uint8_t
+        {
+            STARTS_STEP  = 1 << 0,
+            HOLDS_GROUP  = 1 << 1,
+            HAS_OPERATOR = 1 << 2,
+            HAS_TEXT_ID  = 1 << 3,
+        };
+
+        /* set on the offset of a text kept in @e m_extra_texts */
+        static constexpr std::uint32_t EXTRA_TEXT_BIT { 1U << 31 };
+
+        std::string_view m_text;
+
+        std::pmr::memory_resource *m_arena;
+        std::size_t                m_size { 0 };
+        std::size_t                m_capacity { 0 };
+
+        /* whether the columns belong to another list, see share() */
+        bool m_shared { false };
+
+        /* the columns share one block of the arena, which is replaced
+           by a larger one when the list grows */
+        Position      *m_positions { nullptr };
+        std::uint32_t *m_indexes { nullptr };
+        std::uint32_t *m_offsets { nullptr };
+        std::uint32_t *m_lengths { nullptr };
+        TokenType     *m_types { nullptr };
+        std::uint8_t  *m_flags { nullptr };
+
+        std::pmr::vector<std::string_view> m_extra_texts;
+        std::pmr::vector<TokenGroup *>     m_groups;
+
+        /* the operators of the tokens that have one, by token */
+        std::pmr::vector<std::pair<std::uint32_t, OperatorType>> m_operators;
+
+        /* the ids of the texts taken from the string pool, by token */
+        std::pmr::vector<std::pair<std::uint32_t, utils::StringPool::id>>
+            m_text_ids;
+
+
+        /**
+         * get the location of @p text for the token at @p idx
+         */
+        [[nodiscard]]
+        auto locate_text(std::size_t idx, std::string_view text)
+            -> std::uint32_t;
+
+
+        /**
+         * get the entry of @e m_text_ids of the token at @p idx , or where
+         * it would go
+         */
+        [[nodiscard]]
+        auto find_text_id(std::size_t idx)
+            -> decltype(m_text_ids)::iterator;
+
+
+        /**
+         * moves the columns to a block holding @p capacity tokens
+         */
+        void grow(std::size_t capacity);
+
+
+        /**
+         * copies the columns into the arena of the list if they are
+         * shared with another list, before they are changed
+         */
+        void unshare();
+    };
+
+
     /**
      * a container for @e Token
+     * ------------------------
+     *
+     * every group and token of one input lives inside the arena of
+     * a TokenTree, nested groups point to their parent and are only
+     * released along with the whole tree
      */
     struct TokenGroup
     {
-        std::vector<Token> tokens;
-        std::string        raw;
+        TokenList tokens;
+
+
+        /**
+         * the text of this group, a view into the text of the tree
+         */
+        std::string_view raw;
 
 
         /**
          * the place where the token got its input from, will be "stdin" if
          * input comes from std::cin
          */
-        std::string source;
+        std::string_view source;
+
+
+        /**
+         * used to resolve errors, nullptr on the top-level group
+         */
+        TokenGroup *parent;
+
+
+        /**
+         * the top-most parent of this group, or the group itself
+         */
+        const TokenGroup *toplevel;
+
+
+        /**
+         * the tree the group is allocated from
+         */
+        const TokenTree *tree;
+
+
+        /**
+         * where @e raw starts inside the text of the top-level group
+         */
+        std::size_t offset { 0 };
+
+
+        TokenGroup(std::string_view           raw,
+                   std::string_view           source,
+                   TokenGroup                *parent,
+                   std::pmr::memory_resource *arena);
+
+
+        /**
+         * replaces @p count bytes of @e raw at @p pos with @p replacement ,
+         * the new text is allocated from the arena of the group
+         */
+        void replace_raw(std::size_t      pos,
+                         std::size_t      count,
+                         std::string_view replacement);
+
+
+        /**
+         * allocates a group nested in this one from the same arena,
+         * @p raw must be a view into the text of the tree
+         */
+        [[nodiscard]]
+        auto make_child(std::string_view raw) -> TokenGroup *;
+
+
+        /**
+         * copies @p text into the arena of the group, for token text
+         * that does not appear as is inside @e raw
+         */
+        [[nodiscard]]
+        auto copy_text(std::string_view text) -> std::string_view;
+
+
+        /**
+         * sets the text of the token at @p idx to a copy of @p text
+         * allocated from the arena of the group
+         */
+        void set_text(std::size_t idx, std::string_view text);
 
 
         /**
-         * used to resolve errors
+         * records the position of every token of this top-level group
+         * and of the groups it holds, from the @e offset of each group
+         * and the indexes of its tokens
          */
-        std::weak_ptr<TokenGroup> parent;
+        void set_positions();
 
 
-        TokenGroup(std::string raw, const std::shared_ptr<TokenGroup> &parent);
+        /**
+         * same as set_positions(), for the tokens [ @p first , @p last )
+         * of this top-level group only, @p from is the position of a
+         * character at or before the first of them
+         */
+        void set_positions(std::size_t     first,
+                           std::size_t     last,
+                           const Position &from);
 
 
         /**
@@ -135,10 +544,36 @@ namespace parser
          *
          * returns a parser::Error if theres an error
          *
+         * when @p interactive is false, misspelled commands and paths are
+         * reported without asking whether to correct them
+         *
+         * separate groups can be verified from several threads at once
+         *
          * @warning the function mutates member @e tokens
          */
         [[nodiscard]]
-        auto verify_syntax() -> std::optional<::error::Info>;
+        auto verify_syntax(bool interactive = true)
+            -> std::optional<::error::Info>;
+
+
+        /**
+         * same as verify_syntax(), with the result of check_syntax() for
+         * this group already known as @p syntax , so that only the
+         * commands are checked again
+         *
+         * when @p interactive is false, the group is left unchanged
+         */
+        [[nodiscard]]
+        auto verify_syntax(bool interactive, const SyntaxCheck &syntax)
+            -> std::optional<::error::Info>;
+
+
+        /**
+         * runs the checks of verify_syntax() that only depend on the
+         * tokens, the result stays valid as long as the group does
+         */
+        [[nodiscard]]
+        auto check_syntax() const -> SyntaxCheck;
 
 
         /**
@@ -173,6 +608,9 @@ namespace parser
         }
     };
 
+    /**
+     * a top-level token group, which keeps its whole TokenTree alive
+     */
     using shared_tokens = std::shared_ptr<TokenGroup>;
 
 
@@ -187,6 +625,13 @@ namespace parser
         std::size_t index;
 
 
+        /**
+         * the position of the token inside the text of the top-level
+         * group, recorded once the whole input is parsed
+         */
+        Position position {};
+
+
         /**
          * contains the raw text of the token or another token group
          * ----------------------------------
@@ -194,8 +639,10 @@ namespace parser
          * the text will be '{' or '}' on @e type SUB_BRACKET,
          * " on @e type STRING_QUOTE,
          * or just a raw text on other types.
+         *
+         * the text is a view into the arena of its group's tree
          */
-        std::variant<std::string, shared_tokens> data;
+        std::variant<std::string_view, TokenGroup *> data;
 
 
         /**
@@ -204,9 +651,19 @@ namespace parser
         std::optional<OperatorType> operator_type;
 
 
+        /**
+         * whether the token is the first one of a step of the parser,
+         * the places at which parsing can resume after an edit
+         */
+        bool starts_step { false };
+
+
         Token() = default;
-        Token(TokenType type, std::size_t idx, std::string data);
-        Token(TokenType type, std::size_t idx, const shared_tokens &data);
+        Token(TokenType type, std::size_t idx, std::string_view data);
+        Token(TokenType type, std::size_t idx, TokenGroup *data);
+
+        /* the token would point into a destroyed string */
+        Token(TokenType type, std::size_t idx, std::string &&data) = delete;
 
 
         [[nodiscard]]
@@ -224,6 +681,14 @@ namespace parser
         auto get_highlighted() const -> std::string;
 
 
+        /**
+         * get the text of the token, or std::nullopt if it holds
+         * a token group
+         */
+        [[nodiscard]]
+        auto get_text() const -> std::optional<std::string_view>;
+
+
         /**
          * a wrapper for std::get_if ran on @e data
          */
@@ -235,4 +700,70 @@ namespace parser
             return std::get_if<Tp>(&this->data);
         }
     };
+
+
+    /**
+     * owns every group and token parsed from one input
+     * ------------------------------------------------
+     *
+     * the groups, tokens and the text they point into are allocated
+     * from a single monotonic arena, short lines fit in a block inside
+     * the tree itself, longer ones get one block sized after the text
+     *
+     * nothing inside the arena is destroyed on its own, it is all
+     * released at once along with the tree
+     *
+     * a tree can share groups with the trees it was reparsed from, which
+     * it then keeps alive
+     */
+    class TokenTree
+    {
+    public:
+        /**
+         * @p first_line is the line of @p source that @p text starts at
+         */
+        TokenTree(std::string_view source,
+                  std::string_view text,
+                  std::size_t      first_line = 0);
+
+        TokenTree(const TokenTree &)                     = delete;
+        auto operator=(const TokenTree &) -> TokenTree & = delete;
+
+
+        [[nodiscard]]
+        auto get_root() -> TokenGroup *;
+
+
+        /**
+         * get the line of the source that the text of the tree starts at
+         */
+        [[nodiscard]]
+        auto get_first_line() const -> std::size_t;
+
+
+        /**
+         * keeps the tree of @p tokens alive as long as this one, along
+         * with the trees it keeps alive itself
+         */
+        void keep_alive(const std::shared_ptr<const TokenGroup> &tokens);
+
+
+        /**
+         * get the number of other trees this one keeps alive
+         */
+        [[nodiscard]]
+        auto get_kept_alive_count() const -> std::size_t;
+
+    private:
+        static constexpr std::size_t INITIAL_ARENA_SIZE { 4096 };
+        static constexpr std::size_t INITIAL_ARENA_OVERHEAD { 512 };
+
+        std::array<std::byte, INITIAL_ARENA_SIZE>          m_initial_buffer;
+        std::optional<std::pmr::monotonic_buffer_resource> m_arena;
+
+        TokenGroup *m_root;
+        std::size_t m_first_line;
+
+        std::vector<std::shared_ptr<const TokenGroup>> m_kept_alive;
+    };
 }
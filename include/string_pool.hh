@@ -0,0 +1,109 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string_view>
+#include <vector>
+
+
+namespace utils
+{
+    /**
+     * a set of strings that each get a stable id
+     * -------------------------------------------
+     *
+     * every distinct string is copied once into blocks that are never
+     * moved or freed, so the views given out stay valid as long as the
+     * pool does, and two strings of the same pool are equal exactly when
+     * their ids are
+     *
+     * the strings are found through an open-addressing hash index over
+     * their ids, the pool can be used from several threads at once
+     */
+    class StringPool
+    {
+    public:
+        using id = std::uint32_t;
+
+
+        /**
+         * get the id of @p text , adding a copy of it to the pool
+         * if it is not there yet
+         */
+        [[nodiscard]]
+        auto intern(std::string_view text) -> id;
+
+
+        /**
+         * same as intern(), but get the view of the copy inside the pool
+         */
+        [[nodiscard]]
+        auto intern_view(std::string_view text) -> std::string_view;
+
+
+        /**
+         * get the id of @p text , or std::nullopt if it was never interned
+         */
+        [[nodiscard]]
+        auto find(std::string_view text) const -> std::optional<id>;
+
+
+        [[nodiscard]]
+        auto get(id text_id) const -> std::string_view;
+
+
+        [[nodiscard]]
+        auto size() const -> std::size_t;
+
+    private:
+        static constexpr std::size_t BLOCK_SIZE { 64 * 1024 };
+
+        /* the index is grown once it is half full */
+        static constexpr std::size_t MIN_SLOTS { 1024 };
+
+
+        struct Entry
+        {
+            std::string_view text;
+            std::uint64_t    hash;
+        };
+
+        std::vector<std::unique_ptr<char[]>> m_blocks;
+
+        /* the block being filled, texts bigger than a block are given
+           one of their own instead */
+        char       *m_block { nullptr };
+        std::size_t m_block_used { BLOCK_SIZE };
+
+        std::vector<Entry> m_entries;
+
+        /* the id of the entry plus one, or zero for an empty slot */
+        std::vector<std::uint32_t> m_slots;
+
+        mutable std::shared_mutex m_mutex;
+
+
+        /**
+         * get the slot holding @p text , or the empty slot it would go
+         * into, the index must not be empty
+         */
+        [[nodiscard]]
+        auto find_slot(std::string_view text, std::uint64_t hash) const
+            -> std::size_t;
+
+
+        [[nodiscard]]
+        auto copy_text(std::string_view text) -> std::string_view;
+
+
+        void grow_index();
+    };
+
+
+    /**
+     * get the pool shared by the whole session
+     */
+    [[nodiscard]]
+    auto get_string_pool() -> StringPool &;
+}
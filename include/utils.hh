@@ -1,5 +1,8 @@
 #pragma once
+#include <cstdint>
+#include <filesystem>
 #include <ranges>
+#include <span>
 #include <string>
 
 #include <json/value.h>
@@ -101,15 +104,15 @@ namespace utils
          * trims excess whitespace from @p str
          */
         [[nodiscard]]
-        auto trim(const std::string &str) -> std::string;
+        auto trim(std::string_view str) -> std::string_view;
 
 
         /**
          * splits a string at @p pos , excluding @p pos
          */
         [[nodiscard]]
-        auto split(const std::string &str, std::size_t pos)
-            -> std::pair<std::string, std::string>;
+        auto split(std::string_view str, std::size_t pos)
+            -> std::pair<std::string_view, std::string_view>;
 
 
         /**
@@ -123,10 +126,43 @@ namespace utils
          * calculates the Levenshtein Distance between two strings @p a and @p b
          */
         [[nodiscard]]
-        auto levenshtein_distance(const std::string &a, const std::string &b)
+        auto levenshtein_distance(std::string_view a, std::string_view b)
             -> int;
 
 
+        /**
+         * calculates the Levenshtein Distance between @p a and @p b ,
+         * up to @p max
+         * -----------------------------------------------------------
+         *
+         * the function returns @p max + 1 as soon as the distance is known
+         * to exceed @p max , strings up to 64 bytes are compared with
+         * a bit-parallel algorithm (Myers, Hyyrö)
+         */
+        [[nodiscard]]
+        auto bounded_levenshtein_distance(std::string_view a,
+                                          std::string_view b,
+                                          int              max) -> int;
+
+
+        /**
+         * calculates the bounded Levenshtein Distance between @p query
+         * and each string of @p candidates
+         * ------------------------------------------------------------
+         *
+         * the n-th result belongs to the n-th candidate, and is the same as
+         * what bounded_levenshtein_distance() would return for it
+         *
+         * if @p query is at most 64 bytes, several candidates are scored
+         * at once, one per SIMD lane
+         */
+        [[nodiscard]]
+        auto bounded_levenshtein_distance(
+            std::string_view                  query,
+            std::span<const std::string_view> candidates,
+            int                               max) -> std::vector<int>;
+
+
         /**
          * get the line and column of a string @p text from an index @p index
          */
@@ -257,6 +293,31 @@ namespace utils
     auto getenv(const std::string &env, const std::string &val) -> std::string;
 
 
+    /**
+     * get the cache directory of the shell, the directory
+     * will be created if it does not exist yet
+     * ---------------------------------------------------
+     *
+     * this function may throw an std::runtime_error if $HOME is not set
+     */
+    [[nodiscard]]
+    auto get_cache_path() -> std::filesystem::path;
+
+
+    constexpr std::uint64_t FNV_OFFSET_BASIS { 0xcbf29ce484222325 };
+
+
+    /**
+     * a 64-bit FNV-1a hash of @p text , continuing from @p hash
+     *
+     * the text is taken eight bytes at a time, which is all the cache
+     * files need to notice a change, at a fraction of the cost
+     */
+    [[nodiscard]]
+    auto hash_text(std::string_view text,
+                   std::uint64_t    hash = FNV_OFFSET_BASIS) -> std::uint64_t;
+
+
     /**
      * creates a lazy integer range from
      * @p start (inclusive) to @p end (exclusive)
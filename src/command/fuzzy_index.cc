@@ -0,0 +1,125 @@
+#include <algorithm>
+
+#include "command/fuzzy_index.hh"
+#include "utils.hh"
+
+using cmd::FuzzyIndex;
+
+
+template <typename T_Func>
+void
+FuzzyIndex::walk(std::string_view buffer,
+                 std::string_view name,
+                 int              max_distance,
+                 T_Func         &&on_node) const
+{
+    if (m_nodes.empty()) return;
+
+    std::vector<std::uint32_t> stack { 0 };
+
+    while (!stack.empty())
+    {
+        const Node &node { m_nodes[stack.back()] };
+        stack.pop_back();
+
+        int furthest_child { 0 };
+        for (std::uint32_t child { node.first_child }; child != NONE;
+             child = m_nodes[child].next_sibling)
+            furthest_child = std::max<int>(furthest_child,
+                                           m_nodes[child].distance);
+
+        /* past max_distance + furthest_child neither this node nor any
+           of its children can match, so the exact distance is not needed */
+        int dist { utils::str::bounded_levenshtein_distance(
+            buffer.substr(node.offset, node.length), name,
+            max_distance + furthest_child) };
+
+        if (dist <= max_distance) on_node(node, dist);
+
+        /* by the triangle inequality, only the children whose distance
+           to this node is within max_distance of dist can match */
+        for (std::uint32_t child { node.first_child }; child != NONE;
+             child = m_nodes[child].next_sibling)
+        {
+            if (std::abs(m_nodes[child].distance - dist) <= max_distance)
+                stack.emplace_back(child);
+        }
+    }
+}
+
+
+void
+FuzzyIndex::insert(std::string_view buffer,
+                   std::uint32_t    offset,
+                   std::uint16_t    length)
+{
+    const std::string_view name { buffer.substr(offset, length) };
+
+    if (m_nodes.empty())
+    {
+        m_nodes.push_back({ offset, length, 0, true, NONE, NONE });
+        return;
+    }
+
+    std::uint32_t current { 0 };
+    while (true)
+    {
+        Node &node { m_nodes[current] };
+
+        int dist { utils::str::levenshtein_distance(
+            buffer.substr(node.offset, node.length), name) };
+
+        if (dist == 0)
+        {
+            node.alive = true;
+            return;
+        }
+
+        std::uint32_t child { node.first_child };
+        while (child != NONE && m_nodes[child].distance != dist)
+            child = m_nodes[child].next_sibling;
+
+        if (child != NONE)
+        {
+            current = child;
+            continue;
+        }
+
+        const auto idx { static_cast<std::uint32_t>(m_nodes.size()) };
+        m_nodes.push_back({ offset, length, static_cast<std::uint8_t>(dist),
+                            true, NONE, node.first_child });
+
+        /* push_back may have moved the node */
+        m_nodes[current].first_child = idx;
+        return;
+    }
+}
+
+
+void
+FuzzyIndex::erase(std::string_view buffer, std::string_view name)
+{
+    std::uint32_t target { NONE };
+
+    walk(buffer, name, 0, [&](const Node &node, int) -> void
+         { target = &node - m_nodes.data(); });
+
+    if (target != NONE) m_nodes[target].alive = false;
+}
+
+
+auto
+FuzzyIndex::find(std::string_view buffer,
+                 std::string_view name,
+                 int max_distance) const -> std::vector<Match>
+{
+    std::vector<Match> matches;
+
+    walk(buffer, name, max_distance, [&](const Node &node, int dist) -> void
+         {
+             if (node.alive)
+                 matches.push_back({ node.offset, node.length, dist });
+         });
+
+    return matches;
+}
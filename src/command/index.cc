@@ -0,0 +1,241 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "command/index.hh"
+#include "utils.hh"
+
+using cmd::Index;
+
+
+namespace
+{
+    constexpr std::string_view MAGIC { "BSHCMD02" };
+
+
+    struct FileHeader
+    {
+        char          magic[MAGIC.size()];
+        std::uint32_t count;
+        std::uint32_t reserved;
+
+        /* of everything that follows the header */
+        std::uint64_t records_hash;
+    };
+
+
+    struct RecordHeader
+    {
+        std::uint64_t device;
+        std::uint64_t inode;
+        std::int64_t  mtime_sec;
+        std::int64_t  mtime_nsec;
+        std::uint32_t path_len;
+        std::uint32_t names_len;
+    };
+
+
+    template <typename Tp>
+    void
+    append_pod(std::string &body, const Tp &val)
+    {
+        body.append(reinterpret_cast<const char *>(&val), sizeof(Tp));
+    }
+
+
+    /**
+     * writes the whole of @p data to @p fd , returns false on failure
+     */
+    [[nodiscard]]
+    auto
+    write_all(int fd, std::string_view data) -> bool
+    {
+        while (!data.empty())
+        {
+            const ssize_t written { write(fd, data.data(), data.size()) };
+            if (written < 0 && errno == EINTR) continue;
+            if (written <= 0) return false;
+
+            data.remove_prefix(static_cast<std::size_t>(written));
+        }
+
+        return true;
+    }
+}
+
+
+Index::Index(std::filesystem::path file)
+    : m_file(std::move(file)), m_data(nullptr), m_size(0), m_dirty(false)
+{
+    int fd { open(m_file.c_str(), O_RDONLY | O_CLOEXEC) };
+    if (fd < 0) return;
+
+    struct stat info {};
+    if (fstat(fd, &info) == 0 && info.st_size > 0)
+    {
+        void *data { mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd,
+                          0) };
+
+        if (data != MAP_FAILED)
+        {
+            m_data = static_cast<const char *>(data);
+            m_size = info.st_size;
+        }
+    }
+    close(fd);
+
+    if (m_data != nullptr && !load()) m_records.clear();
+}
+
+
+Index::~Index()
+{
+    if (m_data != nullptr) munmap(const_cast<char *>(m_data), m_size);
+}
+
+
+auto
+Index::Record::matches(const struct stat &info) const -> bool
+{
+    return device == info.st_dev && inode == info.st_ino
+        && mtime_sec == info.st_mtim.tv_sec
+        && mtime_nsec == info.st_mtim.tv_nsec;
+}
+
+
+auto
+Index::load() -> bool
+{
+    FileHeader header {};
+    if (m_size < sizeof(header)) return false;
+
+    std::memcpy(&header, m_data, sizeof(header));
+    if (std::string_view { header.magic, MAGIC.size() } != MAGIC) return false;
+
+    /* every record takes at least its header, a count the file cannot
+       hold would otherwise be trusted with the reservation below */
+    const std::string_view body { m_data + sizeof(header),
+                                  m_size - sizeof(header) };
+    if (header.count > body.size() / sizeof(RecordHeader)
+        || utils::hash_text(body) != header.records_hash)
+        return false;
+
+    std::size_t offset { sizeof(header) };
+    m_records.reserve(header.count);
+
+    for (std::uint32_t i { 0 }; i < header.count; i++)
+    {
+        RecordHeader rec {};
+        if (m_size - offset < sizeof(rec)) return false;
+
+        std::memcpy(&rec, m_data + offset, sizeof(rec));
+        offset += sizeof(rec);
+
+        if (m_size - offset
+            < static_cast<std::size_t>(rec.path_len) + rec.names_len)
+            return false;
+
+        std::string_view path { m_data + offset, rec.path_len };
+        offset += rec.path_len;
+
+        std::string_view names { m_data + offset, rec.names_len };
+        offset += rec.names_len;
+
+        if (!names.empty() && names.back() != '\0') return false;
+
+        m_records.push_back({ path, names, rec.device, rec.inode,
+                              rec.mtime_sec, rec.mtime_nsec, nullptr });
+    }
+
+    return offset == m_size;
+}
+
+
+auto
+Index::find(const std::string &dir, const struct stat &info)
+    -> std::optional<std::string_view>
+{
+    auto it { std::ranges::find(m_records, std::string_view { dir },
+                                &Record::path) };
+
+    if (it == m_records.end() || !it->matches(info)) return std::nullopt;
+
+    m_requested.emplace_back(*it);
+    return it->names;
+}
+
+
+auto
+Index::insert(const std::string &dir,
+              const struct stat &info,
+              std::string        names) -> std::string_view
+{
+    auto storage { std::make_shared<std::string>(dir + names) };
+
+    std::string_view view { *storage };
+    m_requested.push_back({ view.substr(0, dir.length()),
+                            view.substr(dir.length()), info.st_dev,
+                            info.st_ino, info.st_mtim.tv_sec,
+                            info.st_mtim.tv_nsec, std::move(storage) });
+    m_dirty = true;
+
+    return m_requested.back().names;
+}
+
+
+void
+Index::save()
+{
+    if (!m_dirty && m_requested.size() == m_records.size()) return;
+
+    std::string body;
+    for (const auto &record : m_requested)
+    {
+        append_pod(body, RecordHeader {
+                             record.device,
+                             record.inode,
+                             record.mtime_sec,
+                             record.mtime_nsec,
+                             static_cast<std::uint32_t>(record.path.size()),
+                             static_cast<std::uint32_t>(record.names.size()),
+                         });
+        body.append(record.path);
+        body.append(record.names);
+    }
+
+    FileHeader header {};
+    std::memcpy(header.magic, MAGIC.data(), MAGIC.size());
+    header.count        = m_requested.size();
+    header.records_hash = utils::hash_text(body);
+
+    std::string file;
+    append_pod(file, header);
+    file.append(body);
+
+    /* a temporary file of its own, so that shells saving at the same
+       time never write into each other's file */
+    std::string tmp { m_file.string() + ".XXXXXX" };
+
+    const int fd { mkstemp(tmp.data()) };
+    if (fd < 0) return;
+
+    const bool written { write_all(fd, file) };
+    if (close(fd) != 0 || !written)
+    {
+        unlink(tmp.c_str());
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmp, m_file, ec);
+
+    if (ec)
+        unlink(tmp.c_str());
+    else
+        m_dirty = false;
+}
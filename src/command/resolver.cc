@@ -0,0 +1,155 @@
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "command/resolver.hh"
+
+using cmd::Resolver;
+
+
+Resolver::Resolver(const std::vector<std::string> &dirs)
+{
+    m_directories.reserve(dirs.size());
+
+    for (const auto &dir : dirs) m_directories.push_back(open_directory(dir));
+}
+
+
+Resolver::~Resolver()
+{
+    for (const auto &dir : m_directories)
+        if (dir.fd >= 0) close(dir.fd);
+}
+
+
+auto
+Resolver::open_directory(const std::string &path) -> Directory
+{
+    int fd { open(path.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC) };
+
+    struct stat info {};
+    if (fd >= 0 && fstat(fd, &info) != 0)
+    {
+        close(fd);
+        fd = -1;
+    }
+
+    return { path, fd, info.st_mtim, info.st_dev, info.st_ino };
+}
+
+
+void
+Resolver::invalidate_from(std::size_t first)
+{
+    /* a changed directory can shadow or remove anything found after it,
+       and can provide anything that was not found */
+    std::erase_if(m_cache, [first](const auto &entry) -> bool
+                  { return entry.second >= first; });
+}
+
+
+void
+Resolver::invalidate_changed(std::size_t last)
+{
+    std::size_t first_changed { NOT_FOUND };
+
+    for (std::size_t i { 0 }; i <= last && i < m_directories.size(); i++)
+    {
+        auto &dir { m_directories[i] };
+        if (dir.fd < 0) continue;
+
+        struct stat info {};
+        if (fstat(dir.fd, &info) != 0) continue;
+
+        if (info.st_mtim.tv_sec == dir.mtime.tv_sec
+            && info.st_mtim.tv_nsec == dir.mtime.tv_nsec)
+            continue;
+
+        dir.mtime     = info.st_mtim;
+        first_changed = std::min(first_changed, i);
+    }
+
+    if (first_changed != NOT_FOUND) invalidate_from(first_changed);
+}
+
+
+auto
+Resolver::reopen_replaced() -> bool
+{
+    std::size_t first_reopened { NOT_FOUND };
+
+    for (std::size_t i { 0 }; i < m_directories.size(); i++)
+    {
+        auto &dir { m_directories[i] };
+
+        /* a removed directory keeps its handle until one takes its place */
+        struct stat info {};
+        if (stat(dir.path.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+            continue;
+
+        if (dir.fd >= 0 && info.st_dev == dir.device
+            && info.st_ino == dir.inode)
+            continue;
+
+        Directory opened { open_directory(dir.path) };
+        if (opened.fd < 0) continue;
+
+        if (dir.fd >= 0) close(dir.fd);
+        dir            = std::move(opened);
+        first_reopened = std::min(first_reopened, i);
+    }
+
+    if (first_reopened == NOT_FOUND) return false;
+
+    invalidate_from(first_reopened);
+    return true;
+}
+
+
+auto
+Resolver::lookup(std::string_view name) const -> std::size_t
+{
+    std::string file { name };
+
+    for (std::size_t i { 0 }; i < m_directories.size(); i++)
+    {
+        int fd { m_directories[i].fd };
+        if (fd < 0) continue;
+
+        if (faccessat(fd, file.c_str(), X_OK, 0) != 0) continue;
+
+        struct stat info {};
+        if (fstatat(fd, file.c_str(), &info, 0) == 0 && S_ISREG(info.st_mode))
+            return i;
+    }
+
+    return NOT_FOUND;
+}
+
+
+auto
+Resolver::resolve(std::string_view name) -> std::optional<std::filesystem::path>
+{
+    std::scoped_lock lock { m_mutex };
+
+    auto it { m_cache.find(name) };
+
+    if (it != m_cache.end())
+    {
+        invalidate_changed(it->second);
+        it = m_cache.find(name);
+    }
+
+    if (it == m_cache.end()) it = m_cache.emplace(name, lookup(name)).first;
+
+    /* directories are only reopened when it can change the answer,
+       so that a found command costs nothing more */
+    if (it->second == NOT_FOUND && reopen_replaced())
+        it = m_cache.emplace(name, lookup(name)).first;
+
+    if (it->second == NOT_FOUND) return std::nullopt;
+
+    std::filesystem::path path { m_directories[it->second].path };
+    return path /= name;
+}
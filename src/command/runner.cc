@@ -1,32 +1,311 @@
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <span>
+
+#include <unistd.h>
+
+#include "command/index.hh"
+#include "command/resolver.hh"
 #include "command/runner.hh"
+#include "command/scanner.hh"
+#include "command/watcher.hh"
 #include "utils.hh"
 
-
-namespace cmd
+namespace
 {
-    void
-    fill_binary_path_list()
+    std::vector<std::string> PATH_DIRECTORIES;
+
+    /* readers only ever load the current snapshot, writers build a new
+       table and publish it as a whole, one writer at a time */
+    std::atomic<std::shared_ptr<const cmd::Table>> BINARY_PATH_LIST;
+    std::atomic<std::uint64_t>                     BINARY_PATH_GENERATION;
+    std::mutex                                     BINARY_PATH_WRITE_MUTEX;
+
+    cmd::Resolution                RESOLUTION { cmd::Resolution::SCAN };
+    std::once_flag                 RESOLVER_INIT;
+    std::unique_ptr<cmd::Resolver> RESOLVER;
+
+    /* declared after everything its callback uses, so that its thread is
+       joined before any of it is destroyed */
+    std::unique_ptr<cmd::Watcher> PATH_WATCHER;
+
+    /* declared last, so that the scan is joined before anything it uses
+       is destroyed */
+    std::shared_future<void> BINARY_PATH_SCAN;
+
+
+    [[nodiscard]]
+    auto
+    get_path_directories() -> std::vector<std::string>
     {
         std::string path { utils::getenv(
             "PATH", "/usr/local/sbin:/usr/local/bin:/usr/bin") };
 
+        std::vector<std::string> dirs;
+
         std::istringstream iss { path };
         for (std::string dir; std::getline(iss, dir, ':');)
+            if (!dir.empty()) dirs.emplace_back(dir);
+
+        return dirs;
+    }
+
+
+    [[nodiscard]]
+    auto
+    is_executable(const std::string &file) -> bool
+    {
+        struct stat info {};
+        return stat(file.c_str(), &info) == 0 && S_ISREG(info.st_mode)
+            && access(file.c_str(), X_OK) == 0;
+    }
+
+
+    /**
+     * builds the binary path list, the caller must hold the write lock
+     *
+     * the index only spares rescanning the directories that did not
+     * change, if the cache directory cannot be used, every directory
+     * is scanned instead
+     */
+    [[nodiscard]]
+    auto
+    fill_binary_path_list() -> cmd::Table
+    {
+        std::optional<cmd::Index> index;
+        try
+        {
+            index.emplace(utils::get_cache_path() / "commands");
+        }
+        catch (const std::exception &)
         {
-            if (dir.empty()) continue;
-            std::filesystem::path path { dir };
+            index.reset();
+        }
 
-            if (!std::filesystem::exists(path)) continue;
-            std::filesystem::recursive_directory_iterator it { path };
+        std::vector<std::string_view> dir_names(PATH_DIRECTORIES.size());
 
-            for (const auto &entry : it)
-            {
-                if (!entry.is_regular_file()) continue;
+        std::vector<std::string> stale_dirs;
+        std::vector<std::pair<std::size_t, struct stat>> stale_info;
+
+        for (std::size_t i { 0 }; i < PATH_DIRECTORIES.size(); i++)
+        {
+            const auto &dir { PATH_DIRECTORIES[i] };
 
-                const auto &file { entry.path() };
-                if (access(file.c_str(), X_OK) == 0)
-                    BINARY_PATH_LIST[file.filename().string()] = file;
+            struct stat info {};
+            if (stat(dir.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+                continue;
+
+            if (auto names { index ? index->find(dir, info) : std::nullopt })
+                dir_names[i] = *names;
+            else
+            {
+                stale_dirs.emplace_back(dir);
+                stale_info.emplace_back(i, info);
             }
         }
+
+        auto scanned { cmd::scan_directories(stale_dirs) };
+        for (std::size_t i { 0 }; i < scanned.size(); i++)
+        {
+            const auto &[idx, info] { stale_info[i] };
+
+            if (index)
+                dir_names[idx] = index->insert(stale_dirs[i], info,
+                                               std::move(scanned[i]));
+            else
+                dir_names[idx] = scanned[i];
+        }
+
+        std::vector<cmd::Table::directory_names> dirs;
+        dirs.reserve(PATH_DIRECTORIES.size());
+
+        for (std::size_t i { 0 }; i < PATH_DIRECTORIES.size(); i++)
+            dirs.emplace_back(PATH_DIRECTORIES[i], dir_names[i]);
+
+        if (index) index->save();
+
+        /* earlier $PATH directories take precedence over later ones */
+        return cmd::Table { dirs };
+    }
+
+
+    /**
+     * publishes @p table as the binary path list,
+     * the caller must hold the write lock
+     */
+    void
+    publish_binary_path_list(std::shared_ptr<const cmd::Table> table)
+    {
+        BINARY_PATH_LIST.store(std::move(table));
+
+        /* bumped after the store, so that a reader that sees the new
+           generation can only load the new table */
+        BINARY_PATH_GENERATION.fetch_add(1);
+    }
+
+
+    /**
+     * looks up @p name in every $PATH directory and updates
+     * its entry inside @p table
+     */
+    void
+    resolve_binary(cmd::Table &table, std::string_view name)
+    {
+        /* the first directory wins, just like fill_binary_path_list() */
+        for (std::size_t i { 0 }; i < PATH_DIRECTORIES.size(); i++)
+        {
+            std::string file { PATH_DIRECTORIES[i] };
+            file += '/';
+            file += name;
+
+            if (!is_executable(file)) continue;
+
+            table.set(name, static_cast<cmd::Table::dir_id>(i));
+            return;
+        }
+
+        table.erase(name);
+    }
+
+
+    /**
+     * revalidates every entry of @p table found in the directory at
+     * @p dir_idx , and adds the entries the directory has now
+     */
+    void
+    resolve_directory(cmd::Table &table, std::size_t dir_idx)
+    {
+        /* copied, since resolving may grow the table's buffer */
+        std::vector<std::string> names;
+        for (const auto &entry : table)
+            if (entry.directory == dir_idx)
+                names.emplace_back(table.get_name(entry));
+
+        for (const auto &name : names) resolve_binary(table, name);
+
+        /* the directory may have just been created, or replaced by
+           one whose entries were never seen */
+        const std::string listing { cmd::scan_directory(
+            PATH_DIRECTORIES[dir_idx]) };
+
+        for (std::size_t pos { 0 }; pos < listing.length();)
+        {
+            const std::size_t end { listing.find('\0', pos) };
+            resolve_binary(table, std::string_view { listing }.substr(
+                                      pos, end - pos));
+            pos = end + 1;
+        }
+    }
+
+
+    /**
+     * applies a batch of changes to a single copy of the binary path list,
+     * so that a burst of events, like a package being installed, is
+     * published as one snapshot
+     */
+    void
+    on_path_directory_change(std::span<const cmd::Watcher::Change> changes)
+    {
+        std::scoped_lock lock { BINARY_PATH_WRITE_MUTEX };
+
+        const bool events_lost { std::ranges::any_of(
+            changes, [](const cmd::Watcher::Change &change) -> bool
+            { return change.dir_idx >= PATH_DIRECTORIES.size(); }) };
+
+        /* events were lost, the index only rescans what changed */
+        if (events_lost)
+        {
+            publish_binary_path_list(std::make_shared<const cmd::Table>(
+                fill_binary_path_list()));
+            return;
+        }
+
+        auto table { std::make_shared<cmd::Table>(*BINARY_PATH_LIST.load()) };
+
+        for (const auto &[dir_idx, name] : changes)
+        {
+            if (name.empty())
+                resolve_directory(*table, dir_idx);
+            else
+                resolve_binary(*table, name);
+        }
+
+        publish_binary_path_list(std::move(table));
+    }
+
+
+    void
+    scan_binary_path_list()
+    {
+        PATH_DIRECTORIES = get_path_directories();
+
+        /* the watches are added before scanning, so that nothing
+           that changes during the scan is missed */
+        PATH_WATCHER = std::make_unique<cmd::Watcher>(
+            PATH_DIRECTORIES, on_path_directory_change);
+
+        {
+            std::scoped_lock lock { BINARY_PATH_WRITE_MUTEX };
+            publish_binary_path_list(
+                std::make_shared<const cmd::Table>(fill_binary_path_list()));
+        }
+
+        PATH_WATCHER->start();
+    }
+}
+
+
+namespace cmd
+{
+    void
+    start_binary_path_scan()
+    {
+        if (BINARY_PATH_SCAN.valid()) return;
+
+        BINARY_PATH_SCAN
+            = std::async(std::launch::async, scan_binary_path_list).share();
+    }
+
+
+    auto
+    get_binary_path_list() -> std::shared_ptr<const Table>
+    {
+        if (auto table { BINARY_PATH_LIST.load() }) return table;
+
+        start_binary_path_scan();
+        BINARY_PATH_SCAN.get();
+
+        return BINARY_PATH_LIST.load();
+    }
+
+
+    auto
+    get_binary_path_generation() -> std::uint64_t
+    {
+        return BINARY_PATH_GENERATION.load();
+    }
+
+
+    void
+    set_resolution(Resolution resolution)
+    {
+        RESOLUTION = resolution;
+    }
+
+
+    auto
+    binary_exists(std::string_view name) -> bool
+    {
+        if (RESOLUTION == Resolution::SCAN)
+            return get_binary_path_list()->contains(name);
+
+        std::call_once(RESOLVER_INIT, []() -> void
+                       { RESOLVER = std::make_unique<Resolver>(
+                             get_path_directories()); });
+
+        return RESOLVER->resolve(name).has_value();
     }
 }
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "command/scanner.hh"
+
+
+namespace
+{
+    /* large enough to read a typical /usr/bin in a handful of syscalls */
+    constexpr std::size_t DIRENT_BUFFER_SIZE { 128 * 1024 };
+    constexpr std::size_t MAX_SCAN_THREADS { 4 };
+
+
+    [[nodiscard]]
+    auto
+    is_executable(int dir_fd, const char *name, unsigned char type) -> bool
+    {
+        if (type == DT_LNK || type == DT_UNKNOWN)
+        {
+            struct stat info {};
+            if (fstatat(dir_fd, name, &info, 0) != 0) return false;
+            if (!S_ISREG(info.st_mode)) return false;
+        }
+        else if (type != DT_REG)
+            return false;
+
+        return faccessat(dir_fd, name, X_OK, 0) == 0;
+    }
+}
+
+
+namespace cmd
+{
+    auto
+    scan_directory(const std::string &dir) -> std::string
+    {
+        std::string names;
+
+        int fd { open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC) };
+        if (fd < 0) return names;
+
+        auto buff { std::make_unique<char[]>(DIRENT_BUFFER_SIZE) };
+
+        ssize_t len;
+        while ((len = getdents64(fd, buff.get(), DIRENT_BUFFER_SIZE)) > 0)
+        {
+            for (ssize_t i { 0 }; i < len;)
+            {
+                const auto *entry { reinterpret_cast<const dirent64 *>(
+                    buff.get() + i) };
+                i += entry->d_reclen;
+
+                const char *name { entry->d_name };
+                if (name[0] == '.'
+                    && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')))
+                    continue;
+
+                if (!is_executable(fd, name, entry->d_type)) continue;
+
+                names.append(name);
+                names.push_back('\0');
+            }
+        }
+
+        close(fd);
+        return names;
+    }
+
+
+    auto
+    scan_directories(const std::vector<std::string> &dirs)
+        -> std::vector<std::string>
+    {
+        std::vector<std::string> results(dirs.size());
+        std::atomic<std::size_t> next { 0 };
+
+        auto worker { [&]() -> void
+                      {
+                          for (std::size_t i; (i = next++) < dirs.size();)
+                              results[i] = scan_directory(dirs[i]);
+                      } };
+
+        const std::size_t thread_count { std::min<std::size_t>(
+            { dirs.size(), MAX_SCAN_THREADS,
+              std::max(1U, std::thread::hardware_concurrency()) }) };
+
+        /* the calling thread is one of the workers */
+        std::vector<std::jthread> threads;
+        for (std::size_t i { 1 }; i < thread_count; i++)
+            threads.emplace_back(worker);
+
+        worker();
+        threads.clear();
+
+        return results;
+    }
+}
@@ -0,0 +1,168 @@
+#include <algorithm>
+
+#include "command/table.hh"
+
+using cmd::Table;
+
+
+Table::Table(const std::vector<directory_names> &dirs)
+{
+    std::size_t buffer_size { 0 };
+    for (const auto &[dir, names] : dirs)
+        buffer_size += dir.length() + names.length();
+
+    m_buffer.reserve(buffer_size);
+    m_directories.reserve(dirs.size());
+
+    for (std::size_t i { 0 }; i < dirs.size(); i++)
+    {
+        const auto &[dir, names] { dirs[i] };
+
+        m_directories.push_back({ static_cast<std::uint32_t>(m_buffer.size()),
+                                  static_cast<std::uint32_t>(dir.length()) });
+        m_buffer.append(dir);
+
+        /* the names keep their null terminator inside the buffer */
+        std::size_t offset { m_buffer.size() };
+        m_buffer.append(names);
+
+        for (std::size_t end; offset < m_buffer.size(); offset = end + 1)
+        {
+            end = m_buffer.find('\0', offset);
+            m_entries.push_back({ static_cast<std::uint32_t>(offset),
+                                  static_cast<std::uint16_t>(end - offset),
+                                  static_cast<dir_id>(i) });
+        }
+    }
+
+    /* a stable sort keeps the entries of the same name in $PATH order */
+    std::ranges::stable_sort(m_entries, {}, [this](const Entry &entry)
+                             { return get_name(entry); });
+
+    auto [first, last] { std::ranges::unique(
+        m_entries, {}, [this](const Entry &entry)
+        { return get_name(entry); }) };
+    m_entries.erase(first, last);
+
+    for (const auto &entry : m_entries)
+        m_fuzzy_index.insert(m_buffer, entry.name_offset, entry.name_length);
+}
+
+
+auto
+Table::lower_bound(std::string_view name) const
+    -> std::vector<Entry>::const_iterator
+{
+    return std::ranges::lower_bound(m_entries, name, {},
+                                    [this](const Entry &entry)
+                                    { return get_name(entry); });
+}
+
+
+auto
+Table::find(std::string_view name) const -> const Entry *
+{
+    auto it { lower_bound(name) };
+    if (it == m_entries.end() || get_name(*it) != name) return nullptr;
+    return &*it;
+}
+
+
+auto
+Table::contains(std::string_view name) const -> bool
+{
+    return find(name) != nullptr;
+}
+
+
+auto
+Table::find_similar(std::string_view name, int max_distance) const
+    -> std::vector<std::pair<std::string_view, int>>
+{
+    std::vector<std::pair<std::string_view, int>> result;
+
+    for (const auto &match : m_fuzzy_index.find(m_buffer, name, max_distance))
+        result.emplace_back(
+            std::string_view { m_buffer }.substr(match.offset, match.length),
+            match.distance);
+
+    return result;
+}
+
+
+void
+Table::set(std::string_view name, dir_id dir)
+{
+    auto it { lower_bound(name) };
+
+    if (it != m_entries.end() && get_name(*it) == name)
+    {
+        m_entries[it - m_entries.begin()].directory = dir;
+        return;
+    }
+
+    Entry entry { static_cast<std::uint32_t>(m_buffer.size()),
+                  static_cast<std::uint16_t>(name.length()), dir };
+    m_buffer.append(name);
+    m_buffer.push_back('\0');
+
+    m_entries.insert(it, entry);
+    m_fuzzy_index.insert(m_buffer, entry.name_offset, entry.name_length);
+}
+
+
+void
+Table::erase(std::string_view name)
+{
+    /* the name itself stays in the buffer, removals are rare enough
+       that it is not worth compacting */
+    auto it { lower_bound(name) };
+    if (it == m_entries.end() || get_name(*it) != name) return;
+
+    m_fuzzy_index.erase(m_buffer, name);
+    m_entries.erase(it);
+}
+
+
+auto
+Table::get_name(const Entry &entry) const -> std::string_view
+{
+    return { m_buffer.data() + entry.name_offset, entry.name_length };
+}
+
+
+auto
+Table::get_directory(const Entry &entry) const -> std::string_view
+{
+    const auto &dir { m_directories[entry.directory] };
+    return { m_buffer.data() + dir.offset, dir.length };
+}
+
+
+auto
+Table::get_path(const Entry &entry) const -> std::filesystem::path
+{
+    std::filesystem::path path { get_directory(entry) };
+    return path /= get_name(entry);
+}
+
+
+auto
+Table::size() const -> std::size_t
+{
+    return m_entries.size();
+}
+
+
+auto
+Table::begin() const -> std::vector<Entry>::const_iterator
+{
+    return m_entries.begin();
+}
+
+
+auto
+Table::end() const -> std::vector<Entry>::const_iterator
+{
+    return m_entries.end();
+}
@@ -0,0 +1,271 @@
+#include <algorithm>
+#include <array>
+#include <filesystem>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "command/watcher.hh"
+
+using cmd::Watcher;
+
+
+namespace
+{
+    constexpr std::uint32_t WATCH_MASK {
+        IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB
+        | IN_CLOSE_WRITE | IN_DELETE_SELF | IN_MOVE_SELF | IN_ONLYDIR
+    };
+
+    /* the events after which a watch no longer follows its path */
+    constexpr std::uint32_t GONE_MASK { IN_DELETE_SELF | IN_MOVE_SELF
+                                        | IN_IGNORED };
+
+    /* the events on a parent that may have created a missing directory */
+    constexpr std::uint32_t APPEAR_MASK { IN_CREATE | IN_MOVED_TO | GONE_MASK };
+
+    /* how long to wait for more events before dispatching a batch,
+       and how many changes a batch may hold regardless */
+    constexpr int         BATCH_DELAY_MS { 20 };
+    constexpr std::size_t MAX_BATCH_SIZE { 4096 };
+
+
+    [[nodiscard]]
+    auto
+    has_watch(const std::vector<std::pair<int, std::size_t>> &watches, int wd)
+        -> bool
+    {
+        return std::ranges::find(watches, wd,
+                                 &std::pair<int, std::size_t>::first)
+            != watches.end();
+    }
+}
+
+
+Watcher::Watcher(const std::vector<std::string> &dirs, callback on_change)
+    : m_fd(inotify_init1(IN_CLOEXEC)),
+      m_wake_fd(eventfd(0, EFD_CLOEXEC)), m_dirs(dirs),
+      m_on_change(std::move(on_change))
+{
+    if (m_fd < 0) return;
+
+    for (std::size_t i { 0 }; i < m_dirs.size(); i++) add_watch(i);
+}
+
+
+Watcher::~Watcher()
+{
+    if (m_thread.joinable())
+    {
+        std::uint64_t val { 1 };
+        if (write(m_wake_fd, &val, sizeof(val)) == sizeof(val))
+            m_thread.join();
+        else
+            m_thread.detach();
+    }
+
+    if (m_fd >= 0) close(m_fd);
+    if (m_wake_fd >= 0) close(m_wake_fd);
+}
+
+
+void
+Watcher::start()
+{
+    if (m_fd < 0 || m_wake_fd < 0) return;
+    if (m_watches.empty() && m_parent_watches.empty()) return;
+    if (m_thread.joinable()) return;
+
+    m_thread = std::thread { &Watcher::run, this };
+}
+
+
+auto
+Watcher::add_watch(std::size_t dir_idx) -> bool
+{
+    std::filesystem::path path { m_dirs[dir_idx] };
+
+    int wd { inotify_add_watch(m_fd, path.c_str(), WATCH_MASK) };
+    if (wd >= 0)
+    {
+        m_watches.emplace_back(wd, dir_idx);
+        return true;
+    }
+
+    /* the same mask is used for the parents, so that a directory that is
+       both a parent and in the list keeps the events of both */
+    while (path.has_relative_path())
+    {
+        path = path.parent_path();
+        if (path.empty()) break;
+
+        wd = inotify_add_watch(m_fd, path.c_str(), WATCH_MASK);
+        if (wd < 0) continue;
+
+        m_parent_watches.emplace_back(wd, dir_idx);
+        break;
+    }
+
+    return false;
+}
+
+
+void
+Watcher::release_watch(int wd)
+{
+    if (has_watch(m_watches, wd) || has_watch(m_parent_watches, wd)) return;
+
+    inotify_rm_watch(m_fd, wd);
+}
+
+
+void
+Watcher::on_parent_event(int wd)
+{
+    std::vector<std::size_t> missing;
+    std::erase_if(m_parent_watches,
+                  [&](const watch &parent) -> bool
+                  {
+                      if (parent.first != wd) return false;
+                      missing.push_back(parent.second);
+                      return true;
+                  });
+
+    /* the ones still missing go back to waiting on their closest
+       parent, which may now be a deeper one */
+    for (std::size_t dir_idx : missing)
+        if (add_watch(dir_idx)) queue(dir_idx, "");
+
+    release_watch(wd);
+}
+
+
+void
+Watcher::on_directory_gone(int wd, std::uint32_t mask)
+{
+    std::vector<std::size_t> gone;
+    std::erase_if(m_watches,
+                  [&](const watch &dir) -> bool
+                  {
+                      if (dir.first != wd) return false;
+                      gone.push_back(dir.second);
+                      return true;
+                  });
+
+    /* a moved directory keeps its watch, which now follows it elsewhere */
+    if ((mask & IN_MOVE_SELF) != 0) inotify_rm_watch(m_fd, wd);
+
+    for (std::size_t dir_idx : gone)
+    {
+        add_watch(dir_idx);
+        queue(dir_idx, "");
+    }
+
+    release_watch(wd);
+}
+
+
+void
+Watcher::queue(std::size_t dir_idx, std::string_view name)
+{
+    m_pending.push_back({ dir_idx, m_names.length(), name.length() });
+    m_names += name;
+}
+
+
+auto
+Watcher::read_events() -> bool
+{
+    alignas(inotify_event) std::array<char, 16 * 1024> buff;
+
+    ssize_t len;
+    do len = read(m_fd, buff.data(), buff.size());
+    while (len < 0 && errno == EINTR);
+
+    if (len <= 0) return false;
+
+    for (ssize_t i { 0 }; i < len;)
+    {
+        const auto *event { reinterpret_cast<const inotify_event *>(
+            buff.data() + i) };
+        i += static_cast<ssize_t>(sizeof(inotify_event) + event->len);
+
+        if ((event->mask & IN_Q_OVERFLOW) != 0)
+        {
+            queue(std::string::npos, "");
+            continue;
+        }
+
+        if ((event->mask & APPEAR_MASK) != 0
+            && has_watch(m_parent_watches, event->wd))
+            on_parent_event(event->wd);
+
+        auto it { std::ranges::find(m_watches, event->wd, &watch::first) };
+        if (it == m_watches.end()) continue;
+
+        if ((event->mask & GONE_MASK) != 0)
+            on_directory_gone(event->wd, event->mask);
+        else if (event->len > 0)
+            queue(it->second, event->name);
+    }
+
+    return true;
+}
+
+
+void
+Watcher::dispatch()
+{
+    std::vector<Change> changes;
+    changes.reserve(m_pending.size());
+
+    for (const auto &change : m_pending)
+        changes.push_back({ change.dir_idx,
+                            std::string_view { m_names }.substr(
+                                change.name_offset, change.name_length) });
+
+    if (!changes.empty()) m_on_change(changes);
+
+    m_pending.clear();
+    m_names.clear();
+}
+
+
+void
+Watcher::run()
+{
+    std::array<pollfd, 2> fds { {
+        { m_fd, POLLIN, 0 },
+        { m_wake_fd, POLLIN, 0 },
+    } };
+
+    while (true)
+    {
+        if (poll(fds.data(), fds.size(), -1) < 0)
+        {
+            if (errno == EINTR) continue;
+            return;
+        }
+
+        if (fds[1].revents != 0) return;
+        if (fds[0].revents == 0) continue;
+
+        if (!read_events()) return;
+
+        /* the events of a burst, like a package being installed, are
+           gathered into a single batch as long as they keep coming */
+        while (m_pending.size() < MAX_BATCH_SIZE)
+        {
+            const int ready { poll(fds.data(), fds.size(), BATCH_DELAY_MS) };
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready <= 0) break;
+
+            if (fds[1].revents != 0) return;
+            if (!read_events()) return;
+        }
+
+        dispatch();
+    }
+}
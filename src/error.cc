@@ -8,13 +8,26 @@ Info::set_error_context(const std::string &input_source,
                         const std::string &text,
                         std::size_t             idx,
                         std::size_t             len)
+{
+    set_error_context(input_source, text,
+                      utils::str::index_to_line_column(text, idx), len);
+}
+
+
+void
+Info::set_error_context(const std::string      &input_source,
+                        const std::string      &text,
+                        std::spair<std::size_t> pos,
+                        std::size_t             len,
+                        std::size_t             first_line)
 {
     if (input_source.empty() || text.empty()) return;
 
-    m_error_pos    = utils::str::index_to_line_column(text, idx);
+    m_error_pos    = pos;
     m_error_lines  = utils::str::split(text, '\n');
     m_input_source = input_source;
     m_error_len    = len;
+    m_first_line   = first_line;
 }
 
 
@@ -37,19 +50,22 @@ Info::create_pretty_message(bool force) -> std::string
 
     m_pretty_msg
         += std::format("  ╭─[{}{}{}: {}:{}]\n", color::MESSAGE, m_input_source,
-                       color::RESET, m_error_pos.first, m_error_pos.second);
+                       color::RESET, m_first_line + m_error_pos.first,
+                       m_error_pos.second);
 
     for (std::size_t i { 0 }; i <= m_error_pos.first && i < m_error_lines.size();
          i++)
     {
-        /* get the length of right-padding */
-        std::size_t padding_len { m_error_pos.second + m_msg.length()
-                             - m_error_lines[i].length() };
+        /* get the length of right-padding, lines before the error line
+           may be longer than the message */
+        const std::size_t width { m_error_pos.second + m_msg.length() };
+        const std::size_t line_len { m_error_lines[i].length() };
+        std::size_t padding_len { width > line_len ? width - line_len : 0 };
 
         auto background { i % 2 == 0 ? color::LINE_BG : color::LINE_BG_ALT };
         auto line { std::format("{}{}{}{}{} │ {}{}{}\n", background,
-                                color::LINE_NUM, i + 1, color::RESET,
-                                background, m_error_lines[i],
+                                color::LINE_NUM, m_first_line + i + 1,
+                                color::RESET, background, m_error_lines[i],
                                 std::string(padding_len, ' '), color::RESET) };
 
         if (i == m_error_pos.first)
@@ -76,4 +92,10 @@ Info::create_pretty_message(bool force) -> std::string
     m_pretty_msg += "\n";
 
     return m_pretty_msg;
-}
\ No newline at end of file
+}
+
+auto
+Info::get_error_type() const -> std::string_view
+{
+    return m_error_type;
+}
@@ -1,4 +1,3 @@
-#include <format>
 #include <fstream>
 
 #include "history/history.hh"
@@ -20,9 +19,10 @@ Handler::Handler(const std::filesystem::path &history_file) : m_first_run(true)
     }
 
     std::ifstream file { m_history_file };
+    utils::StringPool &pool { utils::get_string_pool() };
 
     for (std::string line; std::getline(file, line);)
-        m_lines.emplace_back(utils::str::trim(line));
+        m_lines.emplace_back(pool.intern(utils::str::trim(line)));
 
     if (!m_lines.empty())
         m_idx = m_lines.size() - 1;
@@ -34,16 +34,7 @@ Handler::Handler(const std::filesystem::path &history_file) : m_first_run(true)
 auto
 Handler::get_default_history_path() -> std::filesystem::path
 {
-    std::string cache_path { utils::getenv("XDG_HOME_CACHE",
-                                           utils::getenv("HOME") + "/.cache") };
-
-    if (cache_path.empty()) throw std::runtime_error("$HOME is not set");
-
-    std::filesystem::path dir { std::format("{}/better/better-shell",
-                                            cache_path) };
-    std::filesystem::create_directories(dir);
-
-    return (dir / "history");
+    return (utils::get_cache_path() / "history");
 }
 
 
@@ -51,11 +42,13 @@ void
 Handler::push_back(const std::string &text)
 {
     if (text.empty() || text[0] == '\n') return;
-    if (!m_lines.empty() && m_lines.back() == text) return;
+
+    utils::StringPool &pool { utils::get_string_pool() };
+    if (!m_lines.empty() && pool.find(text) == m_lines.back()) return;
 
     std::string trimmed { utils::str::trim(text) };
 
-    m_lines.emplace_back(trimmed);
+    m_lines.emplace_back(pool.intern(trimmed));
 
     std::ofstream file { m_history_file, std::ios_base::app };
     if (file.is_open())
@@ -73,19 +66,20 @@ Handler::get_next() -> std::optional<std::string>
     if (m_idx >= m_lines.size() - 1) return std::nullopt;
 
     m_idx++;
-    return m_lines[m_idx];
+    return std::string { utils::get_string_pool().get(m_lines[m_idx]) };
 }
 
 
 auto
 Handler::get_prev() -> std::optional<std::string>
 {
-    if (m_idx == 0) return m_lines[m_idx];
+    const utils::StringPool &pool { utils::get_string_pool() };
+    if (m_idx == 0) return std::string { pool.get(m_lines[m_idx]) };
 
     if (!m_first_run) m_idx--;
 
     m_first_run = false;
-    return m_lines[m_idx];
+    return std::string { pool.get(m_lines[m_idx]) };
 }
 
 
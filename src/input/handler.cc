@@ -63,6 +63,13 @@ Handler::should_exit() const -> bool
 }
 
 
+auto
+Handler::take_tokens(const std::string &str) -> parser::shared_tokens
+{
+    return m_terminal_handler.take_tokens(str);
+}
+
+
 void
 Handler::exit(char code)
 {
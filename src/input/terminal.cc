@@ -2,6 +2,7 @@
 #include <cwchar>
 #include <iostream>
 #include <regex>
+#include <utility>
 
 #include <unistd.h>
 #include <utf8.h>
@@ -199,11 +200,35 @@ Handler::handle(const unsigned char &current,
 }
 
 
+auto
+Handler::take_tokens(const std::string &str) -> parser::shared_tokens
+{
+    auto tokens { std::exchange(m_tokens, nullptr) };
+    if (tokens && tokens->raw != str) return nullptr;
+
+    return tokens;
+}
+
+
+void
+Handler::update_tokens(const std::string &str, const parser::Edit &edit)
+{
+    /* the parser needs something other than whitespace */
+    if (utils::str::is_empty(str))
+        m_tokens = nullptr;
+    else if (m_tokens)
+        m_tokens = parser::reparse(m_tokens, edit);
+    else
+        m_tokens = parser::parse("stdin", str);
+}
+
+
 void
 Handler::insert_char_to_cursor(std::string &str, unsigned char c)
 {
     std::size_t idx { m_pos.get_string_idx(str) };
     str.insert(idx, 1, c);
+    update_tokens(str, { idx, 0, std::string_view { str }.substr(idx, 1) });
 
     if (c == '\n')
     {
@@ -220,6 +245,7 @@ Handler::insert_u8_to_cursor(std::string &str)
 {
     std::size_t idx { m_pos.get_string_idx(str) };
     str.insert(idx, m_u8_buffer);
+    update_tokens(str, { idx, 0, m_u8_buffer });
 
     try
     {
@@ -256,6 +282,7 @@ Handler::handle_backspace(std::string &str, bool ctrl)
         if (!ctrl)
         {
             str.erase(idx - 1, 1);
+            update_tokens(str, { idx - 1, 1, "" });
             m_pos.x--;
 
             io::print("\033[D");
@@ -268,6 +295,7 @@ Handler::handle_backspace(std::string &str, bool ctrl)
         std::size_t first { utils::str::move_idx_to_direction(str, idx, -1) };
 
         str.erase(first, idx - first);
+        update_tokens(str, { first, idx - first, "" });
         m_pos.x -= (idx - first);
 
         RUN_FUNC_N(idx - first, io::print, "\033[D")
@@ -387,6 +415,10 @@ Handler::handle_history(Cursor::Direction direction, std::string &current_text)
         return false;
     if (m_current_text.empty()) m_current_text = current_text;
 
+    /* the text is replaced, it is parsed again from scratch on the next
+       edit */
+    m_tokens = nullptr;
+
     std::string before { current_text };
     if (direction == Cursor::DIR_DOWN)
     {
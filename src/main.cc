@@ -1,3 +1,5 @@
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 
 #include <giomm/init.h>
@@ -6,8 +8,14 @@
 #include "command/runner.hh"
 #include "error.hh"
 #include "input/handler.hh"
+#include "parser/error.hh"
+#include "parser/lint.hh"
 #include "parser/parser.hh"
+#include "parser/script.hh"
+#include "parser/script_cache.hh"
+#include "parser/serializer.hh"
 #include "print.hh"
+#include "utils.hh"
 
 
 namespace
@@ -24,6 +32,8 @@ namespace
         "  {3}Flags:{8}\n"
         "    {4}--command{8} -c {5}{{command}}{8}    run command then exit\n"
         "    {4}--config{8}  -C {5}{{path}}{8}       specify config path\n"
+        "    {4}--lint{8}    -l              check <path> without running it\n"
+        "    {4}--binary{8}  -b              print tokens in binary records\n"
         "\n"
         "  {6}Parameter passed to the `command` flag\n"
         "    must be covered in a double quotation mark (\"){8}\n"
@@ -166,13 +176,171 @@ namespace
         return combined_argv.substr(first_quote + 1,
                                     second_quote - first_quote - 1);
     }
+
+
+    /**
+     * prints @p err , if any, and @p tokens in @p format , the errors go
+     * to stderr when the output is binary, so they do not end up in it
+     */
+    void
+    print_statement(const parser::TokenGroup     &tokens,
+                    std::optional<::error::Info> &err,
+                    parser::OutputFormat          format)
+    {
+        /* kept between statements, so that its buffer is reused */
+        static std::string output;
+
+        if (err)
+            io::println(format == parser::OutputFormat::BINARY ? std::cerr
+                                                               : std::cout,
+                        "{}", err->create_pretty_message());
+
+        output.clear();
+        parser::serialize(tokens, format, output);
+        std::cout.write(output.data(),
+                        static_cast<std::streamsize>(output.size()));
+    }
+
+
+    void
+    handle_statement(const parser::shared_tokens &tokens,
+                     parser::OutputFormat         format)
+    {
+        auto err { tokens->verify_syntax() };
+        print_statement(*tokens, err, format);
+    }
+
+
+    /**
+     * verifies and prints the statement @p text , taken from the parse
+     * cache, a command that does not exist may be corrected, which
+     * changes the tokens, so that case is parsed again and handled
+     * with a tree of its own
+     */
+    void
+    handle_line(std::string_view     source,
+                const std::string   &text,
+                parser::OutputFormat format)
+    {
+        const auto statement { parser::parse_cached(source, text) };
+        auto err { statement->tokens->verify_syntax(false, statement->syntax) };
+
+        if (err
+            && err->get_error_type()
+                   == parser::error::type_to_string(
+                       parser::error::Type::INVALID_COMMAND))
+            return handle_statement(parser::parse(source, text), format);
+
+        print_statement(*statement->tokens, err, format);
+    }
+
+
+    /**
+     * runs the script at @p path one statement at a time, without
+     * reading the whole file into memory
+     */
+    [[nodiscard]]
+    auto
+    run_script(const std::string &path, parser::OutputFormat format) -> int
+    {
+        std::ifstream file { path, std::ios::binary };
+        if (!file)
+        {
+            io::println(std::cerr, "{}: cannot open script '{}'", APP_NAME,
+                        path);
+            return ENOENT;
+        }
+
+        parser::ScriptReader reader { file, path };
+        while (auto tokens { reader.next() }) handle_statement(tokens, format);
+
+        return 0;
+    }
+
+
+    /**
+     * get the first config file that exists in the places listed
+     * in the help message, or std::nullopt if there is none
+     */
+    [[nodiscard]]
+    auto
+    find_config() -> std::optional<std::filesystem::path>
+    {
+        const std::string config_home { utils::getenv("XDG_CONFIG_HOME") };
+        const std::string home { utils::getenv("HOME") };
+
+        std::vector<std::filesystem::path> candidates;
+        if (!config_home.empty())
+            candidates.emplace_back(config_home + "/better/shell/config.bsh");
+        if (!home.empty())
+        {
+            candidates.emplace_back(home + "/better/shell/config.bsh");
+            candidates.emplace_back(home + "/.better_shell.bsh");
+        }
+        candidates.emplace_back("/etc/better/shell/config.bsh");
+
+        for (const auto &path : candidates)
+        {
+            std::error_code ec;
+            if (std::filesystem::is_regular_file(path, ec)) return path;
+        }
+
+        return std::nullopt;
+    }
+
+
+    /**
+     * checks every statement of the config file at @p path without
+     * asking to correct anything, the errors go to stderr so that they
+     * never end up in the output of the statements that follow
+     */
+    void
+    load_config(const std::filesystem::path &path)
+    {
+        auto errors { parser::check_script(path) };
+        if (!errors)
+        {
+            io::println(std::cerr, "{}: cannot open config '{}'", APP_NAME,
+                        path.string());
+            return;
+        }
+
+        for (auto &err : *errors)
+            io::println(std::cerr, "{}", err.create_pretty_message());
+    }
+
+
+    /**
+     * checks every statement of the script at @p path on all cores,
+     * and prints the errors in the order they appear in
+     */
+    [[nodiscard]]
+    auto
+    lint_script(const std::string &path) -> int
+    {
+        std::ifstream file { path, std::ios::binary };
+        if (!file)
+        {
+            io::println(std::cerr, "{}: cannot open script '{}'", APP_NAME,
+                        path);
+            return ENOENT;
+        }
+
+        std::ostringstream content;
+        content << file.rdbuf();
+
+        auto errors { parser::lint_script(content.view(), path) };
+        for (auto &err : errors)
+            io::println("{}", err.create_pretty_message());
+
+        return errors.empty() ? 0 : 1;
+    }
 }
 
 
 auto
 main(int argc, char **argv) -> int
 {
-    cmd::fill_binary_path_list();
     std::setlocale(LC_ALL, "");
     Gio::init();
 
@@ -180,8 +348,54 @@ main(int argc, char **argv) -> int
     if (arg_parser.is_arg("help", 'h', false)) print_help_message(*argv);
     if (arg_parser.is_arg("version", 'v', false)) print_version_info();
 
+    /* taken out first, so that its path is not mistaken for a script */
+    std::optional<std::filesystem::path> config;
+    if (auto config_flag { arg_parser.is_flag("config", 'C', true) })
+    {
+        auto path { arg_parser.get_parameter<std::string>(*config_flag) };
+        if (!path)
+        {
+            io::println(std::cerr, "{}: no path given to --config", APP_NAME);
+            return EINVAL;
+        }
+        config = *path;
+    }
+    else
+        config = find_config();
+
+    /* flags without a parameter are erased from the arguments, so they
+       go before the ones whose index is kept for reading it later */
+    auto lint_flag { arg_parser.is_flag("lint", 'l', false) };
+
+    const auto format { arg_parser.is_flag("binary", 'b', false)
+                            ? parser::OutputFormat::BINARY
+                            : parser::OutputFormat::JSON };
+
     auto command_flag { arg_parser.is_flag("command", 'c', true) };
 
+    /* one-shot commands only need to resolve what they run */
+    if (command_flag)
+        cmd::set_resolution(cmd::Resolution::LAZY);
+    else
+        cmd::start_binary_path_scan();
+
+    /* a trailing non-flag argument is a script to run */
+    std::optional<std::string> script;
+    if (const auto &args { arg_parser.get_args() };
+        !command_flag && !args.empty() && !args.back().starts_with('-'))
+        script = args.back();
+
+    if (lint_flag)
+    {
+        if (script) return lint_script(*script);
+
+        io::println(std::cerr, "{}: no script given to lint", APP_NAME);
+        return EINVAL;
+    }
+
+    if (config) load_config(*config);
+    if (script) return run_script(*script, format);
+
     std::unique_ptr<std::istream> stream;
 
     if (!command_flag)
@@ -216,12 +430,11 @@ main(int argc, char **argv) -> int
             if (utils::str::is_empty(text)) continue;
         }
 
-        auto tokens { parser::parse(source, text) };
-
-        if (auto err { tokens->verify_syntax() })
-            io::println("{}", err->create_pretty_message());
-
-        io::println("{}", Json::to_string(tokens->to_json()));
+        /* the tokens of a line typed into the terminal are known already */
+        if (auto tokens { input.take_tokens(text) })
+            handle_statement(tokens, format);
+        else
+            handle_line(source, text, format);
     }
 
     return 0;
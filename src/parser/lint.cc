@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <atomic>
+#include <optional>
+#include <thread>
+
+#include "parser/lint.hh"
+#include "parser/parser.hh"
+#include "parser/script.hh"
+
+
+namespace parser
+{
+    namespace
+    {
+        /* the number of statements a worker takes at once */
+        constexpr std::size_t BATCH_SIZE { 64 };
+    }
+
+
+    auto
+    lint_script(std::string_view script,
+                std::string_view source,
+                std::size_t      thread_count) -> std::vector<::error::Info>
+    {
+        const std::vector<std::string_view> statements { split_statements(
+            script) };
+
+        /* the errors point into the script, not into their statement */
+        std::vector<std::size_t> first_lines;
+        first_lines.reserve(statements.size());
+
+        LineCounter lines { script };
+        for (const std::string_view statement : statements)
+            first_lines.push_back(lines.get_line(
+                static_cast<std::size_t>(statement.data() - script.data())));
+
+        std::vector<std::optional<::error::Info>> results(statements.size());
+        std::atomic<std::size_t>                  next { 0 };
+
+        auto worker { [&]() -> void
+                      {
+                          for (std::size_t first;
+                               (first = next.fetch_add(BATCH_SIZE))
+                               < statements.size();)
+                          {
+                              const std::size_t last { std::min(
+                                  first + BATCH_SIZE, statements.size()) };
+
+                              for (std::size_t i { first }; i < last; i++)
+                                  results[i]
+                                      = parse(source,
+                                              std::string { statements[i] },
+                                              first_lines[i])
+                                            ->verify_syntax(false);
+                          }
+                      } };
+
+        if (thread_count == 0)
+            thread_count = std::max(1U, std::thread::hardware_concurrency());
+
+        thread_count = std::min(
+            thread_count, (statements.size() + BATCH_SIZE - 1) / BATCH_SIZE);
+
+        /* the calling thread is one of the workers */
+        std::vector<std::jthread> threads;
+        for (std::size_t i { 1 }; i < thread_count; i++)
+            threads.emplace_back(worker);
+
+        worker();
+        threads.clear();
+
+        std::vector<::error::Info> errors;
+        for (auto &result : results)
+            if (result) errors.push_back(std::move(*result));
+
+        return errors;
+    }
+}
@@ -0,0 +1,59 @@
+#include <mutex>
+#include <string>
+
+#include "lru_cache.hh"
+#include "parser/parser.hh"
+
+
+namespace parser
+{
+    namespace
+    {
+        constexpr std::size_t MAX_CACHED_STATEMENTS { 256 };
+
+        /* statements keyed by their source and text */
+        utils::LruCache<std::string, std::shared_ptr<const CachedStatement>>
+                   STATEMENT_CACHE { MAX_CACHED_STATEMENTS };
+        std::mutex STATEMENT_MUTEX;
+
+
+        [[nodiscard]]
+        auto
+        make_statement(std::string_view input_source, const std::string &text)
+            -> std::shared_ptr<const CachedStatement>
+        {
+            shared_tokens tokens { parse(input_source, text) };
+            SyntaxCheck   syntax { tokens->check_syntax() };
+
+            return std::make_shared<const CachedStatement>(
+                CachedStatement { std::move(tokens), std::move(syntax) });
+        }
+    }
+
+
+    auto
+    parse_cached(std::string_view   input_source,
+                 const std::string &text) noexcept
+        -> std::shared_ptr<const CachedStatement>
+    {
+        if (text.length() > MAX_CACHED_LENGTH)
+            return make_statement(input_source, text);
+
+        std::string key { input_source };
+        key += '\0';
+        key += text;
+
+        {
+            std::scoped_lock lock { STATEMENT_MUTEX };
+            if (auto *cached { STATEMENT_CACHE.find(key) }) return *cached;
+        }
+
+        /* parsed without the lock, the same text parsed twice at once
+           just gives the same statement twice */
+        auto statement { make_statement(input_source, text) };
+
+        std::scoped_lock lock { STATEMENT_MUTEX };
+        STATEMENT_CACHE.insert(key, statement);
+        return statement;
+    }
+}
@@ -1,7 +1,13 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <memory>
-#include <stack>
+#include <memory_resource>
 
 #include "parser/parser.hh"
+#include "parser/structural.hh"
+#include "string_pool.hh"
 #include "utils.hh"
 
 using namespace std::literals;
@@ -11,6 +17,76 @@ namespace parser
 {
     namespace
     {
+        /**
+         * what the lexer does with a character
+         * ------------------------------------
+         *
+         * a step is lexed by looking up its first character, instead of
+         * trying every kind of token one after the other
+         */
+        enum class CharKind : std::uint8_t
+        {
+            /* starts a plain word */
+            PARAMETER,
+
+            /* separates the steps */
+            WHITESPACE,
+
+            /* '"', starts a string */
+            STRING,
+
+            /* '{', starts a substitution or an arithmetic expression */
+            BRACKET,
+
+            /* '-', starts a flag after whitespace */
+            FLAG,
+
+            /* an operator, which is not turned into a token */
+            OPERATOR,
+
+            /* '\\', the step is left for the next character */
+            ESCAPE,
+        };
+
+
+        /* the characters of every kind, any other one is a PARAMETER, a
+           new operator only has to be added here */
+        constexpr std::array<std::pair<CharKind, std::string_view>, 6>
+            KIND_CHARS { {
+                { CharKind::WHITESPACE, " \t\n\v\f\r" },
+                { CharKind::STRING, "\"" },
+                { CharKind::BRACKET, "{" },
+                { CharKind::FLAG, "-" },
+                { CharKind::OPERATOR, "!|&;:" },
+                { CharKind::ESCAPE, "\\" },
+            } };
+
+
+        [[nodiscard]]
+        constexpr auto
+        make_kind_table() -> std::array<CharKind, 256>
+        {
+            std::array<CharKind, 256> table {};
+            table.fill(CharKind::PARAMETER);
+
+            for (const auto &[kind, chars] : KIND_CHARS)
+                for (const char ch : chars)
+                    table[static_cast<unsigned char>(ch)] = kind;
+
+            return table;
+        }
+
+        constexpr std::array<CharKind, 256> KIND_TABLE { make_kind_table() };
+
+
+        [[nodiscard]]
+        constexpr auto
+        get_kind(char ch) -> CharKind
+        {
+            return KIND_TABLE[static_cast<unsigned char>(ch)];
+        }
+
+
         /**
          * determines if a char @p ch belongs to token attribute
          * -----------------------------------------------------
@@ -19,73 +95,341 @@ namespace parser
          * so the function will return true
          */
         [[nodiscard]]
-        auto
+        constexpr auto
         char_belongs_to_token(char ch) -> bool
         {
-            return ch == '-' || ch == '{' || ch == '"' || ch == '!' || ch == '|'
-                || ch == '&' || ch == ';' || ch == ':';
+            const CharKind kind { get_kind(ch) };
+            return kind == CharKind::STRING || kind == CharKind::BRACKET
+                || kind == CharKind::FLAG || kind == CharKind::OPERATOR;
+        }
+
+
+        /**
+         * the substitution brackets of a whole input
+         * -------------------------------------------
+         *
+         * found in a single pass before tokenizing, so that a substitution
+         * knows where it ends without scanning the rest of the text, the
+         * brackets inside a string do not count
+         *
+         * the groups are tokenized in the order of the text, so both lists
+         * are read with a cursor that only ever moves forward
+         */
+        struct BracketIndex
+        {
+            struct Pair
+            {
+                std::size_t open;
+
+                /* npos if the bracket is never closed */
+                std::size_t close;
+
+                /* the pair around this one, or npos if there is none */
+                std::size_t parent;
+            };
+
+            /* every opening bracket, in the order of the text */
+            std::pmr::vector<Pair> pairs;
+
+            /* closing brackets that close nothing */
+            std::pmr::vector<std::size_t> unmatched;
+
+            std::size_t next_pair { 0 };
+            std::size_t next_unmatched { 0 };
+
+
+            BracketIndex(std::pmr::memory_resource *arena)
+                : pairs(arena), unmatched(arena)
+            {
+            }
+        };
+
+
+        [[nodiscard]]
+        auto
+        build_bracket_index(std::string_view           text,
+                            const StructuralIndex     &structure,
+                            std::pmr::memory_resource *arena) -> BracketIndex
+        {
+            constexpr std::uint8_t MASK { StructuralIndex::QUOTE
+                                          | StructuralIndex::OPEN_BRACKET
+                                          | StructuralIndex::CLOSE_BRACKET };
+
+            BracketIndex                  index { arena };
+            std::pmr::vector<std::size_t> open { arena };
+
+            bool in_string { false };
+            for (std::size_t i { structure.find(MASK, 0, text.length()) };
+                 i < text.length();
+                 i = structure.find(MASK, i + 1, text.length()))
+            {
+                if (text[i] == '"') in_string = !in_string;
+                if (in_string) continue;
+
+                if (text[i] == '{')
+                {
+                    index.pairs.push_back(
+                        { i, std::string_view::npos,
+                          open.empty() ? std::string_view::npos
+                                       : open.back() });
+                    open.emplace_back(index.pairs.size() - 1);
+                }
+                else if (text[i] == '}' && open.empty())
+                    index.unmatched.emplace_back(i);
+                else if (text[i] == '}')
+                {
+                    index.pairs[open.back()].close = i;
+                    open.pop_back();
+                }
+            }
+
+            return index;
+        }
+
+
+        /**
+         * everything known about the whole input before tokenizing it
+         */
+        struct Input
+        {
+            /* the text every position is relative to */
+            const char *base;
+
+            StructuralIndex structure;
+            BracketIndex    brackets;
+
+
+            Input(std::string_view text, std::pmr::memory_resource *arena)
+                : base(text.data()), structure(text, arena),
+                  brackets(build_bracket_index(text, structure, arena))
+            {
+            }
+        };
+
+
+        /**
+         * get the position of the first character of @p text from
+         * @p from on that belongs to a class of @p mask , or the length
+         * of @p text if there is none
+         */
+        [[nodiscard]]
+        auto
+        find(const Input     &input,
+             std::string_view text,
+             std::size_t      from,
+             std::uint8_t     mask) -> std::size_t
+        {
+            const auto offset { static_cast<std::size_t>(text.data()
+                                                         - input.base) };
+            return input.structure.find(mask, offset + from,
+                                        offset + text.length())
+                 - offset;
+        }
+
+
+        /**
+         * same as find(), but for the first character that belongs
+         * to none of the classes of @p mask
+         */
+        [[nodiscard]]
+        auto
+        find_not(const Input     &input,
+                 std::string_view text,
+                 std::size_t      from,
+                 std::uint8_t     mask) -> std::size_t
+        {
+            const auto offset { static_cast<std::size_t>(text.data()
+                                                         - input.base) };
+            return input.structure.find_not(mask, offset + from,
+                                            offset + text.length())
+                 - offset;
         }
 
 
+        /**
+         * get the pair of the opening bracket at @p pos , or nullptr
+         * if the index does not have it, as for a bracket the index
+         * takes to be inside a string
+         */
         [[nodiscard]]
         auto
-        get_command(const std::string &str) -> std::string
+        find_bracket_pair(BracketIndex &index, std::size_t pos)
+            -> const BracketIndex::Pair *
+        {
+            const auto  &pairs { index.pairs };
+            std::size_t &cursor { index.next_pair };
+
+            while (cursor < pairs.size() && pairs[cursor].open < pos) cursor++;
+
+            if (cursor == pairs.size() || pairs[cursor].open != pos)
+                return nullptr;
+            return &pairs[cursor];
+        }
+
+
+        /**
+         * parses @p text , a view into the text of @p parent ,
+         * into a nested token group
+         */
+        [[nodiscard]]
+        auto parse_group(TokenGroup      *parent,
+                         std::string_view text,
+                         Input           &input) -> TokenGroup *;
+
+
+        constexpr std::size_t MAX_POOLED_WORDS { 1 << 16 };
+        constexpr std::size_t MAX_POOLED_WORD_LENGTH { 64 };
+        constexpr std::size_t RECENT_WORD_COUNT { 256 };
+
+        /* the words the lexer tried to add to the string pool */
+        std::atomic<std::size_t> POOLED_WORDS { 0 };
+
+
+        struct PooledWord
+        {
+            /* the copy inside the pool, which is never moved */
+            std::string_view      text;
+            utils::StringPool::id text_id;
+        };
+
+
+        /**
+         * gives the last token of @p tokens the id of its text in the
+         * string pool
+         * -----------------------------------------------------------
+         *
+         * a text already in the pool is only looked up, a new one is
+         * added until the lexer has added MAX_POOLED_WORDS of them, so
+         * that what is typed during a session cannot grow the pool
+         * without bound
+         *
+         * each thread remembers the words it saw last by their hash, so
+         * that the same command or flag does not take the lock of the
+         * pool on every statement
+         */
+        void
+        pool_last_text(TokenGroup *tokens)
         {
-            std::istringstream iss { str };
-            std::string        word;
-            iss >> word;
-            return word;
+            thread_local std::array<PooledWord, RECENT_WORD_COUNT> recent {};
+
+            TokenList             &list { tokens->tokens };
+            const std::size_t      idx { list.size() - 1 };
+            const std::string_view text { *list.get_text(idx) };
+
+            if (text.empty() || text.length() > MAX_POOLED_WORD_LENGTH)
+                return;
+
+            PooledWord &word { recent[std::hash<std::string_view> {}(text)
+                                      % RECENT_WORD_COUNT] };
+            if (word.text == text)
+            {
+                list.set_text_id(idx, word.text_id);
+                return;
+            }
+
+            utils::StringPool &pool { utils::get_string_pool() };
+            auto               text_id { pool.find(text) };
+
+            if (!text_id
+                && POOLED_WORDS.fetch_add(1, std::memory_order_relaxed)
+                       < MAX_POOLED_WORDS)
+                text_id = pool.intern(text);
+
+            if (!text_id) return;
+
+            word = { pool.get(*text_id), *text_id };
+            list.set_text_id(idx, *text_id);
         }
 
 
+        /**
+         * adds the short flag @p ch at @p idx , its text is taken from
+         * the string pool the first time each thread asks for it
+         */
         void
-        handle_argument(const shared_tokens &tokens,
-                        std::size_t              &i,
-                        const std::string   &text)
+        add_short_flag(TokenGroup *tokens, std::size_t idx, char ch)
+        {
+            thread_local std::array<
+                std::pair<std::string_view, utils::StringPool::id>, 256>
+                flags {};
+
+            auto &[flag, flag_id] { flags[static_cast<unsigned char>(ch)] };
+            if (flag.empty())
+            {
+                utils::StringPool &pool { utils::get_string_pool() };
+
+                flag_id = pool.intern("-"s + ch);
+                flag    = pool.get(flag_id);
+            }
+
+            tokens->add_token(TokenType::FLAG, idx, flag);
+            tokens->tokens.set_text_id(tokens->tokens.size() - 1, flag_id);
+        }
+
+
+        [[nodiscard]]
+        auto
+        get_command(const Input &input, std::string_view str)
+            -> std::string_view
+        {
+            const std::size_t start { find_not(input, str, 0,
+                                               StructuralIndex::WHITESPACE) };
+            const std::size_t end { find(input, str, start,
+                                         StructuralIndex::WHITESPACE) };
+
+            return str.substr(start, end - start);
+        }
+
+
+        void
+        handle_argument(TokenGroup      *tokens,
+                        std::size_t     &i,
+                        std::string_view text,
+                        const Input     &input)
         {
             const std::size_t length { text.length() };
 
-            while (i < length && std::isspace(text[i]) != 0) i++;
+            i = find_not(input, text, i, StructuralIndex::WHITESPACE);
             if (i >= length) return;
 
             if (char_belongs_to_token(text[i])) return;
 
             std::size_t start { i };
-            while (i < length && std::isspace(text[i]) == 0
-                   && !char_belongs_to_token(text[i]))
-            {
-                i++;
-            }
+            i = find(input, text, i,
+                     StructuralIndex::WHITESPACE | StructuralIndex::TOKEN);
 
             if (start < i)
             {
-                std::string  raw { text.substr(start, i - start) };
-                const std::size_t eq_pos { raw.find('=') };
+                const std::string_view raw { text.substr(start, i - start) };
+                const std::size_t      eq_pos { raw.find('=') };
                 auto [argument, param] { utils::str::split(raw, eq_pos) };
 
                 tokens->add_token(TokenType::FLAG, start, argument);
-                if (eq_pos != std::string::npos)
+                pool_last_text(tokens);
+
+                if (eq_pos != std::string_view::npos)
                     tokens->add_token(TokenType::PARAMETER, start + eq_pos,
                                       param);
             }
         }
 
 
-        [[nodiscard]]
-        auto
-        handle_string(const shared_tokens &tokens,
-                      std::size_t              &i,
-                      const std::string   &text) -> bool
+        void
+        handle_string(TokenGroup      *tokens,
+                      std::size_t     &i,
+                      std::string_view text,
+                      const Input     &input)
         {
-            if (text[i] != '"') return false;
-
-            tokens->add_token(TokenType::STRING_QUOTE, i, "\"");
+            tokens->add_token(TokenType::STRING_QUOTE, i, "\""sv);
             i++;
 
-            std::size_t      quote_pos { text.find('"', i) };
-            std::string content;
+            std::size_t quote_pos { find(input, text, i,
+                                         StructuralIndex::QUOTE) };
+            if (quote_pos == text.length()) quote_pos = std::string_view::npos;
+
+            std::string_view content;
 
-            if (quote_pos == std::string::npos)
+            if (quote_pos == std::string_view::npos)
                 content = text.substr(i);
             else
                 content = text.substr(i, quote_pos - i);
@@ -98,241 +442,675 @@ namespace parser
                 /* special case, which allows for
                    error handling if theres no closing quote
                 */
-                if (quote_pos == std::string::npos) return true;
+                if (quote_pos == std::string_view::npos) return;
             }
 
-            tokens->add_token(TokenType::STRING_QUOTE, i, "\"");
+            tokens->add_token(TokenType::STRING_QUOTE, i, "\""sv);
             i++;
-
-            return true;
         }
 
 
-        [[nodiscard]]
-        auto
-        handle_substitution(const shared_tokens &tokens,
-                            std::size_t              &i,
-                            const std::string   &text) -> bool
+        void
+        handle_substitution(TokenGroup      *tokens,
+                            std::size_t     &i,
+                            std::string_view text,
+                            Input           &input)
         {
-            if (text[i] != '{') return false;
-            if (text.length() > i + 1 && text[i + 1] == '{') return false;
+            BracketIndex &brackets { input.brackets };
+            const auto    offset { static_cast<std::size_t>(text.data()
+                                                         - input.base) };
 
-            std::stack<std::size_t>  bracket_pos;
-            std::vector<std::size_t> extra_closing;
-            std::size_t              end_idx { std::string::npos };
-            bracket_pos.emplace(i);
+            const BracketIndex::Pair *pair { find_bracket_pair(brackets,
+                                                               offset + i) };
 
-            tokens->add_token(TokenType::SUB_BRACKET, i++, "{");
+            std::size_t end_idx { std::string_view::npos };
+            if (pair != nullptr && pair->close != std::string_view::npos)
+                end_idx = pair->close - offset;
 
-            for (std::size_t j { i }; j < text.length(); j++)
-            {
-                if (text[j] == '{')
-                {
-                    bracket_pos.emplace(j);
-                    continue;
-                }
-
-                if (text[j] == '}')
-                {
-                    if (bracket_pos.empty()) extra_closing.emplace_back(j);
-                    if (!bracket_pos.empty()) bracket_pos.pop();
-                    if (extra_closing.empty() && end_idx == std::string::npos
-                        && bracket_pos.empty())
-                        end_idx = j;
+            tokens->add_token(TokenType::SUB_BRACKET, i++, "{"sv);
 
-                    continue;
-                }
-            }
-
-            if (end_idx == std::string::npos)
+            if (end_idx == std::string_view::npos)
             {
-                std::string inner { utils::str::trim(text.substr(i)) };
+                std::string_view inner { utils::str::trim(text.substr(i)) };
                 if (!inner.empty())
-                {
-                    shared_tokens inner_tokens { parser::parse(tokens->source,
-                                                               inner, tokens) };
-                    tokens->add_token(TokenType::SUB_CONTENT, i, inner_tokens);
-                }
+                    tokens->add_token(TokenType::SUB_CONTENT, i,
+                                      parse_group(tokens, inner, input));
 
                 i = text.length();
-                return true;
+                return;
             }
 
-            std::string inner { utils::str::trim(text.substr(i, end_idx - i)) };
+            std::string_view inner { utils::str::trim(
+                text.substr(i, end_idx - i)) };
             if (!inner.empty())
-            {
-                shared_tokens inner_tokens { parser::parse(tokens->source,
-                                                           inner, tokens) };
+                tokens->add_token(TokenType::SUB_CONTENT, i,
+                                  parse_group(tokens, inner, input));
 
-                tokens->add_token(TokenType::SUB_CONTENT, i, inner_tokens);
-            }
+            tokens->add_token(TokenType::SUB_BRACKET, end_idx, "}"sv);
+            i = end_idx + 1;
 
-            tokens->add_token(TokenType::SUB_BRACKET, end_idx, "}");
+            /* the closing brackets after the match that no opening bracket
+               after it closes: the ones that close nothing, and the ones
+               of the brackets around this one, which were not lexed as
+               substitutions, or the text would end before them */
+            const std::size_t end { offset + text.length() };
 
-            for (const std::size_t &idx : extra_closing)
-                tokens->add_token(TokenType::SUB_BRACKET, idx, "}");
+            const auto  &unmatched { brackets.unmatched };
+            std::size_t &cursor { brackets.next_unmatched };
 
-            i = (extra_closing.empty() ? end_idx + 1
-                                       : extra_closing.back() + 1);
-            return true;
+            while (cursor < unmatched.size()
+                   && unmatched[cursor] < offset + end_idx)
+                cursor++;
+
+            std::size_t parent { pair->parent };
+            while (true)
+            {
+                std::size_t next { std::string_view::npos };
+                if (parent != std::string_view::npos
+                    && brackets.pairs[parent].close < end)
+                    next = brackets.pairs[parent].close;
+
+                const bool from_unmatched { cursor < unmatched.size()
+                                            && unmatched[cursor] < end
+                                            && unmatched[cursor] < next };
+                if (from_unmatched)
+                    next = unmatched[cursor++];
+                else if (next != std::string_view::npos)
+                    parent = brackets.pairs[parent].parent;
+                else
+                    break;
+
+                tokens->add_token(TokenType::SUB_BRACKET, next - offset,
+                                  "}"sv);
+                i = next - offset + 1;
+            }
         }
 
 
-        [[nodiscard]]
-        auto
-        handle_flag(const shared_tokens &tokens,
-                    std::size_t              &i,
-                    const std::string   &text) -> bool
+        void
+        handle_flag(TokenGroup      *tokens,
+                    std::size_t     &i,
+                    std::string_view text,
+                    const Input     &input)
         {
-            if (i > 0 && (text[i] != '-' || std::isspace(text[i - 1]) == 0))
-                return false;
-
             const std::size_t LEN { text.length() };
 
             /* Handles long arg */
             if (i + 1 < LEN && text[i + 1] == '-')
             {
-                std::size_t len { 2 };
-                bool   after_eq { false };
-
-                while (i + len < LEN && std::isspace(text[i + len]) == 0)
-                {
-                    if (!after_eq && char_belongs_to_token(text[i + len]))
-                        break;
-                    if (text[i + len] == '=') after_eq = true;
-
-                    len++;
-                }
-
-                const std::string raw { text.substr(i, len) };
+                /* the flag ends at a token character, unless it comes
+                   after the value's '=' */
+                std::size_t end { find(input, text, i + 2,
+                                       StructuralIndex::WHITESPACE
+                                           | StructuralIndex::TOKEN
+                                           | StructuralIndex::EQUALS) };
+                if (end < LEN && text[end] == '=')
+                    end = find(input, text, end + 1,
+                               StructuralIndex::WHITESPACE);
+
+                const std::size_t len { end - i };
+
+                const std::string_view raw { text.substr(i, len) };
                 const std::size_t      eq_pos { raw.find('=') };
                 auto [flag, param] { utils::str::split(raw, eq_pos) };
 
                 tokens->add_token(TokenType::FLAG, i, flag);
-                if (eq_pos != std::string::npos)
+                pool_last_text(tokens);
+
+                if (eq_pos != std::string_view::npos)
                     tokens->add_token(TokenType::PARAMETER, i + eq_pos, param);
 
                 i += len - 1;
-                return true;
+                return;
             }
 
-            /* Handle clustered short options: -abc -> -a, -b, -c */
+            /* Handle clustered short options: -abc -> -a, -b, -c, the
+               separated flags come from the session's string pool, so
+               every statement shares the same copy of them */
+            const std::size_t cluster_end { find(
+                input, text, i + 1,
+                StructuralIndex::WHITESPACE | StructuralIndex::EQUALS) };
+
             std::size_t len { 1 };
-            while (i + len < LEN && std::isspace(text[i + len]) == 0
-                   && text[i + len] != '=')
-            {
-                tokens->add_token(TokenType::FLAG, i, "-"s + text[i + len]);
-                len++;
-            }
+            for (; i + len < cluster_end; len++)
+                add_short_flag(tokens, i, text[i + len]);
 
-            if (text[i + len] == '=')
+            if (i + len < LEN && text[i + len] == '=')
             {
                 len++; /* for = */
 
-                std::size_t flag_len { 0 };
-                while (i + len + flag_len < LEN
-                       && std::isspace(text[i + len + flag_len]) == 0)
-                {
-                    flag_len++;
-                }
+                const std::size_t flag_len {
+                    find(input, text, i + len, StructuralIndex::WHITESPACE)
+                    - (i + len)
+                };
 
-                std::string flag { text.substr(i + len, flag_len) };
+                std::string_view flag { text.substr(i + len, flag_len) };
                 tokens->add_token(TokenType::PARAMETER, i + len, flag);
                 i += flag_len;
             }
 
             i += len;
-            return true;
         }
 
 
-        [[nodiscard]]
-        auto
-        handle_arithmetic(const shared_tokens &tokens,
-                          std::size_t              &i,
-                          const std::string   &text) -> bool
+        void
+        handle_arithmetic(TokenGroup      *tokens,
+                          std::size_t     &i,
+                          std::string_view text,
+                          const Input     &input)
         {
-            if (text[i] != '{'
-                || (i + 1 >= text.length() || text[i + 1] != '{'))
-                return false;
-
-            std::size_t end_idx { std::string::npos };
-
-            tokens->add_token(TokenType::ARITHMETIC_BRACKET, i, "{{");
+            tokens->add_token(TokenType::ARITHMETIC_BRACKET, i, "{{"sv);
             i += 2;
 
-            for (std::size_t j { i }; j < text.length() - 1; ++j)
-                if (text[j] == '}')
-                {
-                    end_idx = j;
-                    break;
-                }
+            /* a bracket that is the last character does not count */
+            std::size_t end_idx { find(input, text, i,
+                                       StructuralIndex::CLOSE_BRACKET) };
+            if (end_idx >= text.length() - 1) end_idx = std::string_view::npos;
 
-            if (end_idx == std::string::npos)
+            if (end_idx == std::string_view::npos)
             {
-                std::string inner { utils::str::trim(text.substr(i)) };
+                std::string_view inner { utils::str::trim(text.substr(i)) };
                 if (!inner.empty())
                     tokens->add_token(TokenType::ARITHMETIC_EXPRESSION, i,
                                       inner);
                 i = text.length();
-                return true;
+                return;
             }
 
-            std::string inner { utils::str::trim(text.substr(i, end_idx - i)) };
+            std::string_view inner { utils::str::trim(
+                text.substr(i, end_idx - i)) };
 
             if (!inner.empty())
                 tokens->add_token(TokenType::ARITHMETIC_EXPRESSION, i, inner);
 
-            std::string bracket { text[end_idx] };
-            if (text.length() > end_idx + 1) bracket += text[end_idx + 1];
+            std::string_view bracket { text.substr(end_idx, 2) };
 
             tokens->add_token(TokenType::ARITHMETIC_BRACKET, end_idx, bracket);
 
             i += inner.length() + bracket.length();
-            return true;
+        }
+
+
+        /**
+         * tokenizes the word starting at @p i , which is not whitespace,
+         * and marks the first token it adds as the start of a step
+         */
+        void
+        handle_step(TokenGroup      *tokens,
+                    std::size_t     &i,
+                    std::string_view text,
+                    Input           &input)
+        {
+            const std::size_t start { i };
+            const std::size_t first_token { tokens->tokens.size() };
+
+            switch (get_kind(text[i]))
+            {
+            case CharKind::STRING:
+                handle_string(tokens, i, text, input);
+                break;
+
+            case CharKind::BRACKET:
+                if (i + 1 < text.length() && text[i + 1] == '{')
+                    handle_arithmetic(tokens, i, text, input);
+                else
+                    handle_substitution(tokens, i, text, input);
+                break;
+
+            case CharKind::FLAG:
+                if (i == 0 || get_kind(text[i - 1]) == CharKind::WHITESPACE)
+                    handle_flag(tokens, i, text, input);
+                break;
+
+            case CharKind::PARAMETER:
+            {
+                std::size_t end_idx { find(
+                    input, text, i + 1,
+                    StructuralIndex::WHITESPACE | StructuralIndex::TOKEN) };
+
+                std::string_view param { text.substr(i, end_idx - i) };
+                tokens->add_token(TokenType::PARAMETER, i, param);
+                if (param.find('/') != std::string_view::npos)
+                    pool_last_text(tokens);
+
+                i += param.length();
+                break;
+            }
+
+            case CharKind::WHITESPACE:
+            case CharKind::OPERATOR:
+            case CharKind::ESCAPE:
+                return;
+            }
+
+            /* a lone '-' followed by a value only adds the value, which
+               does not tell where the step started */
+            if (first_token < tokens->tokens.size()
+                && tokens->tokens.get_index(first_token) == start)
+                tokens->tokens.set_starts_step(first_token);
+        }
+
+
+        /**
+         * adds the command and the argument the raw text of @p tokens
+         * starts with, and get where the steps after them start
+         */
+        [[nodiscard]]
+        auto
+        fill_head(TokenGroup *tokens, const Input &input) -> std::size_t
+        {
+            const std::string_view text { tokens->raw };
+
+            const std::string_view cmd { get_command(input, text) };
+            if (!cmd.empty())
+            {
+                tokens->add_token(TokenType::COMMAND, 0, cmd);
+                pool_last_text(tokens);
+            }
+            std::size_t i { cmd.length() };
+
+            handle_argument(tokens, i, text, input);
+            return i;
+        }
+
+
+        /**
+         * splits the raw text of @p tokens into tokens
+         */
+        void
+        fill_tokens(TokenGroup *tokens, Input &input)
+        {
+            const std::string_view text { tokens->raw };
+
+            for (std::size_t i { fill_head(tokens, input) }; i < text.length();
+                 i++)
+            {
+                i = find_not(input, text, i, StructuralIndex::WHITESPACE);
+                if (i >= text.length()) break;
+
+                handle_step(tokens, i, text, input);
+            }
+        }
+
+
+        /* the number of trees a reparsed tree may keep alive before its
+           text is parsed from scratch, so that a line being edited does
+           not hold on to every tree it went through */
+        constexpr std::size_t MAX_KEPT_ALIVE_TREES { 8 };
+
+
+        /**
+         * maps the positions of a text onto the same text with an edit
+         * applied
+         */
+        struct Splice
+        {
+            Edit edit;
+
+
+            /**
+             * get the position in the old text of @p pos , which comes
+             * after the edit in the new text
+             */
+            [[nodiscard]]
+            auto
+            to_old(std::size_t pos) const -> std::size_t
+            {
+                return pos - edit.inserted.length() + edit.removed;
+            }
+        };
+
+
+        /**
+         * moves the positions of the tokens that come after an edit
+         */
+        struct PositionShift
+        {
+            std::ptrdiff_t offset;
+            std::ptrdiff_t lines;
+
+            /* the line the edit ends on in the old text, and where that
+               line starts in the new one */
+            std::size_t edit_line;
+            std::size_t edit_line_start;
+
+
+            [[nodiscard]]
+            auto
+            apply(const Position &position) const -> Position
+            {
+                const auto offset_after { static_cast<std::size_t>(
+                    static_cast<std::ptrdiff_t>(position.offset) + offset) };
+                const auto line_after { static_cast<std::uint32_t>(
+                    position.line + lines) };
+
+                if (position.line != edit_line)
+                    return { offset_after, line_after, position.column };
+
+                return { offset_after, line_after,
+                         static_cast<std::uint32_t>(offset_after
+                                                    - edit_line_start) };
+            }
+        };
+
+
+        [[nodiscard]]
+        auto
+        count_lines(std::string_view text) -> std::ptrdiff_t
+        {
+            return std::ranges::count(text, '\n');
+        }
+
+
+        /**
+         * get where the line holding the character at @p pos of @p text
+         * starts
+         */
+        [[nodiscard]]
+        auto
+        get_line_start(std::string_view text, std::size_t pos) -> std::size_t
+        {
+            const std::size_t newline { text.substr(0, pos).rfind('\n') };
+            return newline == std::string_view::npos ? 0 : newline + 1;
+        }
+
+
+        [[nodiscard]]
+        auto share_group(const TokenGroup    *group,
+                         TokenGroup          *parent,
+                         const PositionShift *shift) -> TokenGroup *;
+
+
+        /**
+         * replaces the groups held by the tokens [ @p first , @p last ) of
+         * @p tokens , which are still the ones of the tree it was reparsed
+         * from, with groups of its own sharing their tokens, and get
+         * whether there were any
+         */
+        auto
+        share_groups(TokenGroup          *tokens,
+                     std::size_t          first,
+                     std::size_t          last,
+                     const PositionShift *shift) -> bool
+        {
+            const auto types { tokens->tokens.get_types() };
+            bool       shared { false };
+
+            for (std::size_t i { first }; i < last; i++)
+            {
+                if (types[i] != TokenType::SUB_CONTENT) continue;
+
+                tokens->tokens.set_group(
+                    i, share_group(tokens->tokens.get_group(i), tokens, shift));
+                shared = true;
+            }
+
+            return shared;
+        }
+
+
+        /**
+         * get a group nested in @p parent that holds the same tokens as
+         * @p group , a group of the tree @p parent was reparsed from, the
+         * tokens are only copied once they are changed
+         *
+         * the positions are moved by @p shift if @p group comes after the
+         * edit, or kept as they are if it is nullptr
+         */
+        auto
+        share_group(const TokenGroup    *group,
+                    TokenGroup          *parent,
+                    const PositionShift *shift) -> TokenGroup *
+        {
+            const auto offset { static_cast<std::size_t>(
+                static_cast<std::ptrdiff_t>(group->offset)
+                + (shift != nullptr ? shift->offset : 0)) };
+
+            TokenGroup *shared { parent->make_child(
+                parent->toplevel->raw.substr(offset, group->raw.length())) };
+            shared->offset = offset;
+            shared->tokens.share(group->tokens);
+
+            share_groups(shared, 0, shared->tokens.size(), shift);
+
+            if (shift != nullptr)
+            {
+                const auto positions { group->tokens.get_positions() };
+                for (std::size_t i { 0 }; i < positions.size(); i++)
+                    shared->tokens.set_position(i, shift->apply(positions[i]));
+            }
+
+            return shared;
+        }
+
+
+        /**
+         * get the first of the top-level @p tokens that has to be lexed
+         * again after @p edit , which starts a step, or 0 if the whole
+         * text does
+         *
+         * @p structural tells whether the edit adds or removes a quote or
+         * a bracket
+         */
+        [[nodiscard]]
+        auto
+        find_restart(const TokenList &tokens, const Edit &edit, bool structural)
+            -> std::size_t
+        {
+            const auto indexes { tokens.get_indexes() };
+            const auto lengths { tokens.get_lengths() };
+
+            /* the last step that starts before the edit, the ones before it
+               end before the edit too */
+            std::size_t restart { static_cast<std::size_t>(
+                std::ranges::lower_bound(indexes, edit.offset)
+                - indexes.begin()) };
+            while (restart > 0 && !tokens.starts_step(restart - 1)) restart--;
+            if (restart-- == 0) return 0;
+
+            /* a step can read past its last character, as the closing
+               bracket of an arithmetic expression does, so the earliest
+               step holding a token that reaches the edit is lexed again */
+            for (std::size_t j { 0 }; j < restart; j++)
+                if (indexes[j] + lengths[j] > edit.offset)
+                {
+                    restart = j;
+                    break;
+                }
+
+            /* the first substitution takes every closing bracket after it
+               that closes nothing, and adding or removing a bracket or a
+               quote anywhere after it changes which ones do */
+            if (structural)
+                for (std::size_t j { 0 }; j < restart; j++)
+                    if (tokens.get_type(j) == TokenType::SUB_BRACKET
+                        && tokens.starts_step(j))
+                    {
+                        restart = j;
+                        break;
+                    }
+
+            while (restart > 0 && !tokens.starts_step(restart)) restart--;
+            return restart;
+        }
+
+
+        auto
+        parse_group(TokenGroup      *parent,
+                    std::string_view text,
+                    Input           &input) -> TokenGroup *
+        {
+            TokenGroup *tokens { parent->make_child(text) };
+            tokens->offset = static_cast<std::size_t>(text.data() - input.base);
+
+            fill_tokens(tokens, input);
+            return tokens;
         }
     }
 
 
     auto
-    parse(std::string          input_source,
-          const std::string   &text,
-          const shared_tokens &parent) noexcept -> shared_tokens
+    parse(std::string_view   input_source,
+          const std::string &text,
+          std::size_t        first_line) noexcept -> shared_tokens
     {
         error::assert(!text.empty(), "input text is empty");
-        auto tokens { std::make_shared<TokenGroup>(text, parent) };
-        tokens->source = std::move(input_source);
 
-        if (std::string cmd { get_command(text) }; !cmd.empty())
-            tokens->add_token(TokenType::COMMAND, 0, cmd);
-        std::size_t i { tokens->tokens.back().get_data<std::string>()->length() };
+        auto        tree { std::make_shared<TokenTree>(input_source, text,
+                                                       first_line) };
+        TokenGroup *root { tree->get_root() };
 
-        handle_argument(tokens, i, text);
+        Input input { root->raw, root->tokens.get_allocator().resource() };
+        fill_tokens(root, input);
+        root->set_positions();
 
-        for (; i < text.length(); i++)
+        /* the group shares ownership of the tree it lives in */
+        return { tree, root };
+    }
+
+
+    auto
+    reparse(const shared_tokens &previous, const Edit &edit) noexcept
+        -> shared_tokens
+    {
+        const std::string_view old_text { previous->raw };
+
+        error::assert(previous->parent == nullptr,
+                      "only a top-level group can be reparsed");
+        error::assert(edit.offset + edit.removed <= old_text.length(),
+                      "edit is out of range");
+
+        std::string text { old_text.substr(0, edit.offset) };
+        text += edit.inserted;
+        text += old_text.substr(edit.offset + edit.removed);
+
+        const std::size_t first_line { previous->tree->get_first_line() };
+
+        if (previous->tree->get_kept_alive_count() >= MAX_KEPT_ALIVE_TREES)
+            return parse(previous->source, text, first_line);
+
+        const std::string_view removed { old_text.substr(edit.offset,
+                                                         edit.removed) };
+
+        constexpr std::string_view STRUCTURAL_CHARS { "\"{}" };
+        const bool structural {
+            removed.find_first_of(STRUCTURAL_CHARS) != std::string_view::npos
+            || edit.inserted.find_first_of(STRUCTURAL_CHARS)
+                   != std::string_view::npos
+        };
+
+        const auto &old_tokens { previous->tokens };
+        const auto  old_indexes { old_tokens.get_indexes() };
+
+        /* the command and its argument are read before the first step,
+           up to the character that ends them */
+        constexpr std::string_view WHITESPACE_CHARS { " \t\n\v\f\r" };
+        const std::size_t command_start { old_text.find_first_not_of(
+            WHITESPACE_CHARS) };
+        std::size_t head_end { std::min(
+            old_text.find_first_of(WHITESPACE_CHARS, command_start),
+            old_text.length()) };
+
+        for (std::size_t j { 0 };
+             j < old_tokens.size() && !old_tokens.starts_step(j); j++)
         {
-            if (std::isspace(text[i]) != 0) continue;
-            if (text[i] == '\\') continue;
+            if (old_tokens.get_type(j) == TokenType::COMMAND) continue;
 
-            if (handle_string(tokens, i, text)) continue;
-            if (handle_substitution(tokens, i, text)) continue;
-            if (handle_flag(tokens, i, text)) continue;
-            if (handle_arithmetic(tokens, i, text)) continue;
+            const std::size_t end { old_indexes[j]
+                                    + old_tokens.get_text(j)->length() };
+            head_end = std::max(head_end, end);
+        }
 
-            if (!char_belongs_to_token(text[i]))
-            {
-                std::size_t end_idx { i + 1 };
-                while (end_idx < text.length()
-                       && std::isspace(text[end_idx]) == 0
-                       && !char_belongs_to_token(text[end_idx]))
-                    end_idx++;
+        const std::size_t restart {
+            edit.offset <= head_end
+                ? 0
+                : find_restart(old_tokens, edit, structural)
+        };
 
-                std::string param { text.substr(i, end_idx - i) };
-                tokens->add_token(TokenType::PARAMETER, i, param);
-                i += param.length();
+        auto        tree { std::make_shared<TokenTree>(previous->source,
+                                                       text, first_line) };
+        TokenGroup *root { tree->get_root() };
+
+        /* the steps before the edit are kept as they are, along with the
+           groups they hold */
+        root->tokens.reserve(old_tokens.size());
+        root->tokens.append(old_tokens, 0, restart, 0);
+        bool shared { share_groups(root, 0, restart, nullptr) };
+
+        Input input { root->raw, root->tokens.get_allocator().resource() };
+
+        const Splice      splice { edit };
+        const std::size_t edit_end { edit.offset + edit.inserted.length() };
+
+        /* the first of the old tokens that is kept after the edit */
+        std::size_t suffix { restart };
+
+        std::size_t i { restart == 0 ? fill_head(root, input)
+                                     : std::size_t { old_indexes[restart] } };
+        for (; i < text.length(); i++)
+        {
+            i = find_not(input, root->raw, i, StructuralIndex::WHITESPACE);
+            if (i >= text.length()) break;
+
+            /* a step that starts past the edit, and after a character that
+               was not edited, gives the same tokens it gave before, unless
+               the edit changed how the brackets and quotes pair up */
+            if (!structural && i > edit_end)
+            {
+                const std::size_t old_index { splice.to_old(i) };
+                while (suffix < old_tokens.size()
+                       && (old_indexes[suffix] < old_index
+                           || (old_indexes[suffix] == old_index
+                               && !old_tokens.starts_step(suffix))))
+                    suffix++;
+
+                if (suffix < old_tokens.size()
+                    && old_indexes[suffix] == old_index)
+                    break;
             }
+
+            handle_step(root, i, root->raw, input);
         }
 
-        return tokens;
+        const std::size_t lexed_end { root->tokens.size() };
+
+        /* the steps after it are kept too, moved by the change in length */
+        if (i < text.length())
+        {
+            const auto        positions { old_tokens.get_positions() };
+            const Position   &first { positions[suffix] };
+            const std::size_t old_edit_end { edit.offset + edit.removed };
+            const std::size_t newline { edit.inserted.rfind('\n') };
+
+            const PositionShift shift {
+                static_cast<std::ptrdiff_t>(edit.inserted.length())
+                    - static_cast<std::ptrdiff_t>(edit.removed),
+                count_lines(edit.inserted) - count_lines(removed),
+                first.line
+                    - static_cast<std::size_t>(count_lines(old_text.substr(
+                        old_edit_end, first.offset - old_edit_end))),
+                newline != std::string_view::npos
+                    ? edit.offset + newline + 1
+                    : get_line_start(old_text, edit.offset),
+            };
+
+            root->tokens.append(old_tokens, suffix, old_tokens.size(),
+                                shift.offset);
+
+            for (std::size_t j { suffix }; j < old_tokens.size(); j++)
+                root->tokens.set_position(lexed_end + j - suffix,
+                                          shift.apply(positions[j]));
+
+            shared |= share_groups(root, lexed_end, root->tokens.size(),
+                                   &shift);
+        }
+
+        root->set_positions(restart, lexed_end,
+                            restart == 0
+                                ? Position {}
+                                : root->tokens.get_positions()[restart - 1]);
+
+        if (shared) tree->keep_alive(previous);
+        return { tree, root };
     }
 }
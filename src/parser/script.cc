@@ -0,0 +1,146 @@
+#include <algorithm>
+
+#include "parser/parser.hh"
+#include "parser/script.hh"
+#include "utils.hh"
+
+using parser::LineCounter;
+using parser::ScriptReader;
+using parser::StatementScanner;
+
+
+ScriptReader::ScriptReader(std::istream    &stream,
+                           std::string_view source,
+                           std::size_t      window_size)
+    : m_stream(&stream), m_source(source), m_window(window_size),
+      m_window_pos(0), m_window_end(0), m_line(0)
+{
+}
+
+
+auto
+ScriptReader::fill_window() -> bool
+{
+    m_stream->read(m_window.data(),
+                   static_cast<std::streamsize>(m_window.size()));
+
+    m_window_pos = 0;
+    m_window_end = static_cast<std::size_t>(m_stream->gcount());
+    return m_window_end > 0;
+}
+
+
+auto
+StatementScanner::find_end(std::string_view chunk, char previous)
+    -> std::size_t
+{
+    constexpr std::string_view SPECIAL_CHARS { "\"{}\n" };
+
+    for (std::size_t i { chunk.find_first_of(SPECIAL_CHARS) };
+         i != std::string_view::npos;
+         i = chunk.find_first_of(SPECIAL_CHARS, i + 1))
+    {
+        const char ch { chunk[i] };
+
+        if (ch == '"') m_in_string = !m_in_string;
+        if (m_in_string) continue;
+
+        if (ch == '{') m_depth++;
+        else if (ch == '}' && m_depth > 0) m_depth--;
+        else if (ch == '\n' && m_depth == 0
+                 && (i > 0 ? chunk[i - 1] : previous) != '\\')
+            return i;
+    }
+
+    return std::string_view::npos;
+}
+
+
+auto
+parser::split_statements(std::string_view script)
+    -> std::vector<std::string_view>
+{
+    std::vector<std::string_view> statements;
+    StatementScanner              scanner;
+
+    for (std::size_t start { 0 }; start < script.length();)
+    {
+        const std::string_view rest { script.substr(start) };
+        const std::size_t      end { std::min(scanner.find_end(rest, '\0'),
+                                              rest.length()) };
+
+        const std::string_view statement { rest.substr(0, end) };
+        if (!std::ranges::all_of(statement, [](unsigned char ch) -> bool
+                                 { return std::isspace(ch) != 0; }))
+            statements.push_back(statement);
+
+        start += end + 1;
+    }
+
+    return statements;
+}
+
+
+LineCounter::LineCounter(std::string_view text) : m_text(text) {}
+
+
+auto
+LineCounter::get_line(std::size_t pos) -> std::size_t
+{
+    pos = std::min(pos, m_text.length());
+
+    /* going back is rare enough to start over */
+    if (pos < m_pos)
+    {
+        m_pos  = 0;
+        m_line = 0;
+    }
+
+    m_line += static_cast<std::size_t>(std::count(
+        m_text.begin() + static_cast<std::ptrdiff_t>(m_pos),
+        m_text.begin() + static_cast<std::ptrdiff_t>(pos), '\n'));
+    m_pos = pos;
+
+    return m_line;
+}
+
+
+auto
+ScriptReader::next() -> shared_tokens
+{
+    StatementScanner scanner;
+    m_statement.clear();
+
+    while (m_window_pos < m_window_end || fill_window())
+    {
+        const std::string_view chunk { m_window.data() + m_window_pos,
+                                       m_window_end - m_window_pos };
+
+        const std::size_t end { scanner.find_end(
+            chunk, m_statement.empty() ? '\0' : m_statement.back()) };
+
+        if (end == std::string_view::npos)
+        {
+            m_statement.append(chunk);
+            m_window_pos = m_window_end;
+            continue;
+        }
+
+        m_statement.append(chunk.substr(0, end));
+        m_window_pos += end + 1;
+
+        const std::size_t first_line { m_line };
+        m_line += static_cast<std::size_t>(std::ranges::count(m_statement,
+                                                              '\n'))
+                + 1;
+
+        if (!utils::str::is_empty(m_statement))
+            return parse(m_source, m_statement, first_line);
+
+        m_statement.clear();
+    }
+
+    /* the last statement may be missing its newline, or be left open */
+    if (utils::str::is_empty(m_statement)) return nullptr;
+    return parse(m_source, m_statement, m_line);
+}
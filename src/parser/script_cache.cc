@@ -0,0 +1,751 @@
+#include <cstring>
+#include <fstream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "parser/parser.hh"
+#include "parser/script.hh"
+#include "parser/script_cache.hh"
+#include "utils.hh"
+
+namespace fs = std::filesystem;
+
+
+namespace parser
+{
+    namespace
+    {
+        constexpr std::string_view MAGIC { "BSHAST03" };
+
+        /* set on the offset of a text stored in the string table of the
+           cache file, instead of inside the statement */
+        constexpr std::uint32_t STRING_TABLE_BIT { 1U << 31 };
+
+
+        struct FileHeader
+        {
+            char          magic[MAGIC.size()];
+            std::uint64_t script_size;
+            std::int64_t  mtime_sec;
+            std::int64_t  mtime_nsec;
+            std::uint64_t content_hash;
+            std::uint32_t path_len;
+            std::uint32_t statement_count;
+            std::uint32_t group_count;
+            std::uint32_t token_count;
+            std::uint32_t strings_len;
+            std::uint32_t reserved;
+
+            /* of everything that follows the header */
+            std::uint64_t records_hash;
+        };
+
+
+        struct TextRecord
+        {
+            std::uint32_t offset;
+            std::uint32_t length;
+        };
+
+
+        enum StatementFlag : std::uint32_t
+        {
+            HAS_SYNTAX_ERROR = 1 << 0,
+        };
+
+
+        /**
+         * a statement, with the result of TokenGroup::check_syntax(), so
+         * that its commands can be checked without rebuilding its groups
+         */
+        struct StatementRecord
+        {
+            /* relative to the start of the script */
+            std::uint32_t offset;
+            std::uint32_t length;
+
+            /* the groups of the statement follow those of the previous */
+            std::uint32_t group_count;
+            std::uint32_t entered_groups;
+            std::uint32_t flags;
+        };
+
+
+        /**
+         * the groups are stored in the order they are visited, a group
+         * always comes right before the first group it holds
+         */
+        struct GroupRecord
+        {
+            /* relative to the start of the statement */
+            TextRecord    raw;
+            std::uint32_t offset;
+            std::uint32_t first_token;
+            std::uint32_t token_count;
+        };
+
+
+        enum TokenFlag : std::uint8_t
+        {
+            HAS_OPERATOR = 1 << 0,
+            STARTS_STEP  = 1 << 1,
+            HOLDS_GROUP  = 1 << 2,
+        };
+
+
+        struct TokenRecord
+        {
+            std::uint8_t  type;
+            std::uint8_t  flags;
+            std::uint8_t  operator_type;
+            std::uint8_t  reserved;
+            std::uint32_t index;
+
+            /* the id of the group instead, if the token holds one */
+            TextRecord data;
+        };
+
+
+        template <typename Tp>
+        void
+        append_records(std::string &body, const std::vector<Tp> &records)
+        {
+            body.append(reinterpret_cast<const char *>(records.data()),
+                        records.size() * sizeof(Tp));
+        }
+
+
+        /**
+         * a read-only mapping of a whole file
+         */
+        class MappedFile
+        {
+        public:
+            MappedFile(const fs::path &path) : m_stat(), m_data(nullptr)
+            {
+                int fd { open(path.c_str(), O_RDONLY | O_CLOEXEC) };
+                if (fd < 0) return;
+
+                if (fstat(fd, &m_stat) != 0 || !S_ISREG(m_stat.st_mode))
+                {
+                    close(fd);
+                    return;
+                }
+
+                m_open = true;
+
+                if (m_stat.st_size > 0)
+                {
+                    void *data { mmap(nullptr, m_stat.st_size, PROT_READ,
+                                      MAP_PRIVATE, fd, 0) };
+
+                    if (data != MAP_FAILED)
+                        m_data = static_cast<const char *>(data);
+                    else
+                        m_open = false;
+                }
+                close(fd);
+            }
+
+
+            ~MappedFile()
+            {
+                if (m_data != nullptr)
+                    munmap(const_cast<char *>(m_data), m_stat.st_size);
+            }
+
+
+            MappedFile(const MappedFile &)                     = delete;
+            auto operator=(const MappedFile &) -> MappedFile & = delete;
+
+
+            [[nodiscard]]
+            auto
+            is_open() const -> bool
+            {
+                return m_open;
+            }
+
+
+            [[nodiscard]]
+            auto
+            get_stat() const -> const struct stat &
+            {
+                return m_stat;
+            }
+
+
+            [[nodiscard]]
+            auto
+            get_text() const -> std::string_view
+            {
+                if (m_data == nullptr) return {};
+                return { m_data, static_cast<std::size_t>(m_stat.st_size) };
+            }
+
+        private:
+            struct stat m_stat;
+            const char *m_data;
+            bool        m_open { false };
+        };
+
+
+        /**
+         * get the cache file of the script at @p source , or std::nullopt
+         * if the cache directory cannot be used
+         */
+        [[nodiscard]]
+        auto
+        get_cache_file(const std::string &source) -> std::optional<fs::path>
+        {
+            fs::path dir;
+            try
+            {
+                dir = utils::get_cache_path() / "scripts";
+            }
+            catch (const std::exception &)
+            {
+                return std::nullopt;
+            }
+
+            std::error_code ec;
+            fs::create_directories(dir, ec);
+            if (ec) return std::nullopt;
+
+            return dir / std::format("{:016x}", utils::hash_text(source));
+        }
+
+
+        /**
+         * the token groups of every statement of a script, flattened
+         * into records to be written to a cache file
+         */
+        class CacheWriter
+        {
+        public:
+            /**
+             * adds @p root , parsed from the text at @p offset of
+             * the script, of which @p syntax is the syntax check
+             */
+            void
+            add_statement(std::size_t        offset,
+                          const TokenGroup  &root,
+                          const SyntaxCheck &syntax)
+            {
+                const std::size_t first_group { m_groups.size() };
+                add_group(root.raw, root);
+
+                m_statements.push_back(
+                    { static_cast<std::uint32_t>(offset),
+                      static_cast<std::uint32_t>(root.raw.length()),
+                      static_cast<std::uint32_t>(m_groups.size()
+                                                 - first_group),
+                      static_cast<std::uint32_t>(syntax.entered_groups),
+                      syntax.error ? HAS_SYNTAX_ERROR : 0U });
+            }
+
+
+            /**
+             * writes the records to @p file , with @p header describing
+             * the script they were parsed from
+             */
+            void
+            save(const fs::path    &file,
+                 FileHeader         header,
+                 const std::string &source) const
+            {
+                std::memcpy(header.magic, MAGIC.data(), MAGIC.size());
+                header.path_len        = source.length();
+                header.statement_count = m_statements.size();
+                header.group_count     = m_groups.size();
+                header.token_count     = m_tokens.size();
+                header.strings_len     = m_strings.size();
+
+                std::string body { source };
+                append_records(body, m_statements);
+                append_records(body, m_groups);
+                append_records(body, m_tokens);
+                body.append(m_strings);
+
+                header.records_hash = utils::hash_text(body);
+
+                fs::path tmp { file };
+                tmp += ".tmp";
+
+                {
+                    std::ofstream out { tmp,
+                                        std::ios::binary | std::ios::trunc };
+                    if (!out.is_open()) return;
+
+                    out.write(reinterpret_cast<const char *>(&header),
+                              sizeof(header));
+                    out.write(body.data(),
+                              static_cast<std::streamsize>(body.length()));
+
+                    if (!out) return;
+                }
+
+                std::error_code ec;
+                fs::rename(tmp, file, ec);
+            }
+
+        private:
+            std::vector<StatementRecord> m_statements;
+            std::vector<GroupRecord>     m_groups;
+            std::vector<TokenRecord>     m_tokens;
+            std::string                  m_strings;
+
+
+            /**
+             * get the location of @p text inside @p statement , or inside
+             * the string table if the statement does not contain it
+             */
+            [[nodiscard]]
+            auto
+            add_text(std::string_view statement, std::string_view text)
+                -> TextRecord
+            {
+                const auto begin { reinterpret_cast<std::uintptr_t>(
+                    text.data()) };
+                const auto statement_begin {
+                    reinterpret_cast<std::uintptr_t>(statement.data())
+                };
+
+                const auto length { static_cast<std::uint32_t>(
+                    text.length()) };
+
+                if (begin >= statement_begin
+                    && begin + text.length()
+                           <= statement_begin + statement.length())
+                    return { static_cast<std::uint32_t>(begin
+                                                        - statement_begin),
+                             length };
+
+                /* the brackets and quotes point to literals, the text
+                   is the same wherever it is taken from */
+                if (const std::size_t pos { statement.find(text) };
+                    pos != std::string_view::npos)
+                    return { static_cast<std::uint32_t>(pos), length };
+
+                const auto offset { static_cast<std::uint32_t>(
+                    m_strings.size()) };
+                m_strings.append(text);
+                return { offset | STRING_TABLE_BIT, length };
+            }
+
+
+            auto
+            add_group(std::string_view statement, const TokenGroup &group)
+                -> std::uint32_t
+            {
+                const auto id { static_cast<std::uint32_t>(m_groups.size()) };
+                const auto first_token { static_cast<std::uint32_t>(
+                    m_tokens.size()) };
+
+                m_groups.push_back(
+                    { add_text(statement, group.raw),
+                      static_cast<std::uint32_t>(group.offset), first_token,
+                      static_cast<std::uint32_t>(group.tokens.size()) });
+
+                /* the slots are taken first, the nested groups add their
+                   own tokens after them */
+                m_tokens.resize(m_tokens.size() + group.tokens.size());
+
+                for (std::size_t i { 0 }; i < group.tokens.size(); i++)
+                {
+                    const Token &token { group.tokens[i] };
+
+                    TokenRecord record {};
+                    record.type  = static_cast<std::uint8_t>(token.type);
+                    record.index = static_cast<std::uint32_t>(token.index);
+
+                    if (token.starts_step) record.flags |= STARTS_STEP;
+                    if (token.operator_type)
+                    {
+                        record.flags |= HAS_OPERATOR;
+                        record.operator_type
+                            = static_cast<std::uint8_t>(*token.operator_type);
+                    }
+
+                    if (auto text { token.get_text() })
+                        record.data = add_text(statement, *text);
+                    else
+                    {
+                        record.flags |= HOLDS_GROUP;
+                        record.data.offset = add_group(
+                            statement, **token.get_data<TokenGroup *>());
+                    }
+
+                    m_tokens[first_token + i] = record;
+                }
+
+                return id;
+            }
+        };
+
+
+        /**
+         * the sections of a mapped cache file
+         */
+        class CacheReader
+        {
+        public:
+            /**
+             * checks that @p data is a cache file of the script at
+             * @p source , of which @p script is the current content
+             */
+            CacheReader(std::string_view   data,
+                        const std::string &source,
+                        const MappedFile  &script,
+                        std::uint64_t      content_hash)
+            {
+                FileHeader header {};
+                if (data.length() < sizeof(header)) return;
+                std::memcpy(&header, data.data(), sizeof(header));
+
+                const struct stat &st { script.get_stat() };
+
+                if (std::string_view { header.magic, MAGIC.size() } != MAGIC
+                    || header.script_size
+                           != static_cast<std::uint64_t>(st.st_size)
+                    || header.mtime_sec != st.st_mtim.tv_sec
+                    || header.mtime_nsec != st.st_mtim.tv_nsec
+                    || header.content_hash != content_hash)
+                    return;
+
+                const std::size_t expected_size {
+                    sizeof(header) + header.path_len
+                    + header.statement_count * sizeof(StatementRecord)
+                    + header.group_count * sizeof(GroupRecord)
+                    + header.token_count * sizeof(TokenRecord)
+                    + header.strings_len
+                };
+                if (data.length() != expected_size
+                    || utils::hash_text(data.substr(sizeof(header)))
+                           != header.records_hash)
+                    return;
+
+                std::size_t offset { sizeof(header) };
+                if (data.substr(offset, header.path_len) != source) return;
+                offset += header.path_len;
+
+                m_statements = data.data() + offset;
+                offset += header.statement_count * sizeof(StatementRecord);
+                m_groups = data.data() + offset;
+                offset += header.group_count * sizeof(GroupRecord);
+                m_tokens = data.data() + offset;
+                offset += header.token_count * sizeof(TokenRecord);
+                m_strings = data.substr(offset);
+
+                m_statement_count = header.statement_count;
+                m_group_count     = header.group_count;
+                m_token_count     = header.token_count;
+                m_valid           = true;
+            }
+
+
+            /**
+             * checks every statement of @p script the way
+             * verify_syntax(false) does, or returns std::nullopt if the
+             * records are corrupted
+             * ---------------------------------------------------------
+             *
+             * the commands are read from the mapped records, the groups
+             * of a statement are only rebuilt when it has an error, to
+             * create the error from them
+             */
+            [[nodiscard]]
+            auto
+            check(std::string_view script, const std::string &source)
+                -> std::optional<std::vector<::error::Info>>
+            {
+                if (!m_valid) return std::nullopt;
+
+                std::vector<::error::Info> errors;
+                std::size_t                first_group { 0 };
+                LineCounter                lines { script };
+
+                for (std::size_t i { 0 }; i < m_statement_count; i++)
+                {
+                    const auto record { get<StatementRecord>(m_statements,
+                                                             i) };
+                    if (std::size_t { record.offset } + record.length
+                            > script.length()
+                        || record.length == 0 || record.group_count == 0
+                        || record.entered_groups > record.group_count
+                        || first_group + record.group_count > m_group_count)
+                        return std::nullopt;
+
+                    const std::string_view statement {
+                        script.substr(record.offset, record.length)
+                    };
+
+                    if ((record.flags & HAS_SYNTAX_ERROR) != 0
+                        || !commands_exist(statement, first_group,
+                                           record.entered_groups))
+                    {
+                        auto tokens { read_statement(
+                            statement, source,
+                            lines.get_line(record.offset), first_group,
+                            record.group_count) };
+                        if (!tokens) return std::nullopt;
+
+                        if (auto err { tokens->verify_syntax(false) })
+                            errors.push_back(std::move(*err));
+                    }
+
+                    first_group += record.group_count;
+                }
+
+                return errors;
+            }
+
+        private:
+            const char      *m_statements { nullptr };
+            const char      *m_groups { nullptr };
+            const char      *m_tokens { nullptr };
+            std::string_view m_strings;
+
+            std::size_t m_statement_count { 0 };
+            std::size_t m_group_count { 0 };
+            std::size_t m_token_count { 0 };
+            bool        m_valid { false };
+
+            /* the groups are read in the order they were written */
+            std::size_t m_next_group { 0 };
+
+
+            template <typename Tp>
+            [[nodiscard]]
+            static auto
+            get(const char *section, std::size_t i) -> Tp
+            {
+                Tp record {};
+                std::memcpy(&record, section + i * sizeof(Tp), sizeof(Tp));
+                return record;
+            }
+
+
+            /**
+             * get @p text from @p statement or from the string table,
+             * which is unmapped along with the cache file
+             */
+            [[nodiscard]]
+            auto
+            view_text(std::string_view statement, TextRecord text) const
+                -> std::optional<std::string_view>
+            {
+                const std::string_view in_table {
+                    (text.offset & STRING_TABLE_BIT) != 0 ? m_strings
+                                                          : statement
+                };
+                const std::size_t offset { text.offset & ~STRING_TABLE_BIT };
+
+                if (offset + text.length > in_table.length())
+                    return std::nullopt;
+                return in_table.substr(offset, text.length);
+            }
+
+
+            [[nodiscard]]
+            auto
+            read_text(TokenGroup *root, TextRecord text) const
+                -> std::optional<std::string_view>
+            {
+                auto view { view_text(root->raw, text) };
+                if (view && (text.offset & STRING_TABLE_BIT) != 0)
+                    return root->copy_text(*view);
+                return view;
+            }
+
+
+            /**
+             * checks the first token of @p count groups from @p first ,
+             * the groups verify_syntax() checks the commands of
+             *
+             * returns false if one may not exist, which includes the
+             * records being corrupted
+             */
+            [[nodiscard]]
+            auto
+            commands_exist(std::string_view statement,
+                           std::size_t      first,
+                           std::size_t      count) const -> bool
+            {
+                for (std::size_t id { first }; id < first + count; id++)
+                {
+                    const auto group { get<GroupRecord>(m_groups, id) };
+                    if (group.token_count == 0
+                        || group.first_token >= m_token_count)
+                        return false;
+
+                    const auto front { get<TokenRecord>(m_tokens,
+                                                        group.first_token) };
+                    if ((front.flags & HOLDS_GROUP) != 0) return false;
+
+                    auto text { view_text(statement, front.data) };
+                    if (!text || !is_valid_command(*text)) return false;
+                }
+
+                return true;
+            }
+
+
+            /**
+             * rebuilds the @p group_count groups of @p statement ,
+             * starting at @p first_group , or returns nullptr if the
+             * records are corrupted
+             *
+             * @p first_line is the line of the script the statement
+             * starts at
+             */
+            [[nodiscard]]
+            auto
+            read_statement(std::string_view   statement,
+                           const std::string &source,
+                           std::size_t        first_line,
+                           std::size_t        first_group,
+                           std::size_t        group_count) -> shared_tokens
+            {
+                auto        tree { std::make_shared<TokenTree>(
+                    source, statement, first_line) };
+                TokenGroup *root { tree->get_root() };
+
+                m_next_group = first_group + 1;
+                if (!read_group(first_group, root, root)
+                    || m_next_group != first_group + group_count)
+                    return nullptr;
+
+                root->set_positions();
+                return { tree, root };
+            }
+
+
+            [[nodiscard]]
+            auto
+            read_group(std::size_t id, TokenGroup *group, TokenGroup *root)
+                -> bool
+            {
+                const auto record { get<GroupRecord>(m_groups, id) };
+                if (std::size_t { record.first_token } + record.token_count
+                        > m_token_count
+                    || record.offset > root->raw.length())
+                    return false;
+
+                group->offset = record.offset;
+
+                group->tokens.reserve(record.token_count);
+
+                for (std::size_t i { record.first_token };
+                     i < record.first_token + record.token_count; i++)
+                {
+                    const auto token_record { get<TokenRecord>(m_tokens, i) };
+
+                    if (token_record.type
+                            > static_cast<std::uint8_t>(
+                                TokenType::ARITHMETIC_EXPRESSION)
+                        || token_record.operator_type
+                               > static_cast<std::uint8_t>(
+                                   OperatorType::PIPE))
+                        return false;
+
+                    Token token {};
+                    token.type  = static_cast<TokenType>(token_record.type);
+                    token.index = token_record.index;
+                    token.starts_step
+                        = (token_record.flags & STARTS_STEP) != 0;
+
+                    if ((token_record.flags & HAS_OPERATOR) != 0)
+                        token.operator_type = static_cast<OperatorType>(
+                            token_record.operator_type);
+
+                    if ((token_record.flags & HOLDS_GROUP) == 0)
+                    {
+                        auto text { read_text(root, token_record.data) };
+                        if (!text) return false;
+                        token.data = *text;
+                    }
+                    else
+                    {
+                        const std::size_t child_id { m_next_group++ };
+                        if (token_record.data.offset != child_id
+                            || child_id >= m_group_count)
+                            return false;
+
+                        auto raw { read_text(
+                            root, get<GroupRecord>(m_groups, child_id).raw) };
+                        if (!raw) return false;
+
+                        TokenGroup *child { group->make_child(*raw) };
+                        if (!read_group(child_id, child, root)) return false;
+                        token.data = child;
+                    }
+
+                    group->tokens.push_back(token);
+                }
+
+                return true;
+            }
+        };
+    }
+
+
+    auto
+    check_script(const fs::path &path)
+        -> std::optional<std::vector<::error::Info>>
+    {
+        const MappedFile script { path };
+        if (!script.is_open()) return std::nullopt;
+
+        const std::string      source { path.string() };
+        const std::string_view text { script.get_text() };
+        const std::uint64_t    content_hash { utils::hash_text(text) };
+        const auto             cache_file { get_cache_file(source) };
+
+        if (cache_file)
+        {
+            const MappedFile cache { *cache_file };
+            CacheReader      reader { cache.get_text(), source, script,
+                                      content_hash };
+
+            if (auto errors { reader.check(text, source) }) return errors;
+        }
+
+        std::vector<::error::Info> errors;
+        CacheWriter                writer;
+        LineCounter                lines { text };
+
+        for (const std::string_view statement : split_statements(text))
+        {
+            const std::size_t offset { static_cast<std::size_t>(
+                statement.data() - text.data()) };
+
+            const auto tokens { parse(source, std::string { statement },
+                                      lines.get_line(offset)) };
+            const SyntaxCheck syntax { tokens->check_syntax() };
+
+            if (auto err { tokens->verify_syntax(false, syntax) })
+                errors.push_back(std::move(*err));
+
+            writer.add_statement(offset, *tokens, syntax);
+        }
+
+        if (cache_file)
+        {
+            const struct stat &st { script.get_stat() };
+
+            FileHeader header {};
+            header.script_size  = static_cast<std::uint64_t>(st.st_size);
+            header.mtime_sec    = st.st_mtim.tv_sec;
+            header.mtime_nsec   = st.st_mtim.tv_nsec;
+            header.content_hash = content_hash;
+
+            writer.save(*cache_file, header, source);
+        }
+
+        return errors;
+    }
+}
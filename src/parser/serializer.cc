@@ -0,0 +1,294 @@
+#include <array>
+#include <charconv>
+
+#include "parser/serializer.hh"
+
+using namespace std::literals;
+
+
+namespace parser
+{
+    namespace
+    {
+        /* the indentation of one level, the same as Json::to_string() */
+        constexpr std::size_t INDENT_WIDTH { 4 };
+
+        constexpr std::string_view HEX_DIGITS { "0123456789abcdef" };
+
+        constexpr unsigned REPLACEMENT_CHARACTER { 0xFFFD };
+
+
+        void
+        append_newline(std::string &out, std::size_t level)
+        {
+            out += '\n';
+            out.append(level * INDENT_WIDTH, ' ');
+        }
+
+
+        void
+        append_unicode_escape(std::string &out, unsigned codepoint)
+        {
+            out += "\\u"sv;
+            for (int shift { 12 }; shift >= 0; shift -= 4)
+                out += HEX_DIGITS[(codepoint >> shift) & 0xF];
+        }
+
+
+        /**
+         * decodes the UTF-8 sequence starting at @p it , leaving @p it on
+         * its last byte, invalid sequences give U+FFFD the same way
+         * jsoncpp does
+         */
+        [[nodiscard]]
+        auto
+        decode_utf8(const char *&it, const char *end) -> unsigned
+        {
+            const auto byte { [&](std::size_t idx) -> unsigned
+                              {
+                                  return static_cast<unsigned char>(it[idx])
+                                       & 0x3F;
+                              } };
+            const auto first { static_cast<unsigned char>(*it) };
+
+            if (first < 0x80) return first;
+
+            if (first < 0xE0)
+            {
+                if (end - it < 2) return REPLACEMENT_CHARACTER;
+
+                const unsigned codepoint { ((first & 0x1FU) << 6) | byte(1) };
+                it += 1;
+                return codepoint < 0x80 ? REPLACEMENT_CHARACTER : codepoint;
+            }
+
+            if (first < 0xF0)
+            {
+                if (end - it < 3) return REPLACEMENT_CHARACTER;
+
+                const unsigned codepoint { ((first & 0x0FU) << 12)
+                                           | (byte(1) << 6) | byte(2) };
+                it += 2;
+
+                /* surrogates are not valid on their own */
+                if (codepoint >= 0xD800 && codepoint <= 0xDFFF)
+                    return REPLACEMENT_CHARACTER;
+                return codepoint < 0x800 ? REPLACEMENT_CHARACTER : codepoint;
+            }
+
+            if (first < 0xF8)
+            {
+                if (end - it < 4) return REPLACEMENT_CHARACTER;
+
+                const unsigned codepoint { ((first & 0x07U) << 18)
+                                           | (byte(1) << 12) | (byte(2) << 6)
+                                           | byte(3) };
+                it += 3;
+                return codepoint < 0x10000 ? REPLACEMENT_CHARACTER
+                                           : codepoint;
+            }
+
+            return REPLACEMENT_CHARACTER;
+        }
+
+
+        /**
+         * appends @p text as a JSON string, escaped the way jsoncpp
+         * escapes it, with everything outside of ASCII as \\u escapes
+         */
+        void
+        append_quoted(std::string &out, std::string_view text)
+        {
+            out += '"';
+
+            const char *end { text.data() + text.length() };
+            for (const char *it { text.data() }; it != end; it++)
+            {
+                switch (*it)
+                {
+                case '"':  out += "\\\""sv; continue;
+                case '\\': out += "\\\\"sv; continue;
+                case '\b': out += "\\b"sv; continue;
+                case '\f': out += "\\f"sv; continue;
+                case '\n': out += "\\n"sv; continue;
+                case '\r': out += "\\r"sv; continue;
+                case '\t': out += "\\t"sv; continue;
+                default:   break;
+                }
+
+                const unsigned codepoint { decode_utf8(it, end) };
+
+                if (codepoint < 0x20) append_unicode_escape(out, codepoint);
+                else if (codepoint < 0x80) out += static_cast<char>(codepoint);
+                else if (codepoint < 0x10000)
+                    append_unicode_escape(out, codepoint);
+                else
+                {
+                    /* as a surrogate pair */
+                    const unsigned rest { codepoint - 0x10000 };
+                    append_unicode_escape(out,
+                                          0xD800 + ((rest >> 10) & 0x3FF));
+                    append_unicode_escape(out, 0xDC00 + (rest & 0x3FF));
+                }
+            }
+
+            out += '"';
+        }
+
+
+        void
+        append_number(std::string &out, std::size_t number)
+        {
+            std::array<char, 20> buffer {};
+            auto [ptr, ec] { std::to_chars(
+                buffer.data(), buffer.data() + buffer.size(), number) };
+
+            out.append(buffer.data(), ptr);
+        }
+
+
+        /**
+         * writes @p group as an object whose opening bracket is already
+         * indented, with its members at @p level + 1
+         */
+        void
+        write_json_group(const TokenGroup &group,
+                         std::size_t       level,
+                         std::string      &out)
+        {
+            const TokenList &tokens { group.tokens };
+
+            out += '{';
+            append_newline(out, level + 1);
+            out += "\"raw\": "sv;
+            append_quoted(out, group.raw);
+            out += ',';
+            append_newline(out, level + 1);
+            out += "\"tokens\": "sv;
+
+            if (tokens.empty())
+                out += "[]"sv;
+            else
+            {
+                append_newline(out, level + 1);
+                out += '[';
+
+                for (std::size_t i { 0 }; i < tokens.size(); i++)
+                {
+                    if (i > 0) out += ',';
+                    append_newline(out, level + 2);
+                    out += '{';
+                    append_newline(out, level + 3);
+                    out += "\"data\": "sv;
+
+                    if (tokens.get_type(i) == TokenType::SUB_CONTENT)
+                    {
+                        append_newline(out, level + 3);
+                        write_json_group(*tokens.get_group(i), level + 3, out);
+                    }
+                    else
+                        append_quoted(out, *tokens.get_text(i));
+
+                    out += ',';
+                    append_newline(out, level + 3);
+                    out += "\"index\": "sv;
+                    append_number(out, tokens.get_index(i));
+                    out += ',';
+                    append_newline(out, level + 3);
+                    out += "\"type\": "sv;
+                    append_quoted(out,
+                                  TokenType_to_string(tokens.get_type(i)));
+                    append_newline(out, level + 2);
+                    out += '}';
+                }
+
+                append_newline(out, level + 1);
+                out += ']';
+            }
+
+            append_newline(out, level);
+            out += '}';
+        }
+
+
+        void
+        append_varint(std::string &out, std::size_t number)
+        {
+            while (number >= 0x80)
+            {
+                out += static_cast<char>((number & 0x7F) | 0x80);
+                number >>= 7;
+            }
+            out += static_cast<char>(number);
+        }
+
+
+        void
+        append_text(std::string &out, std::string_view text)
+        {
+            append_varint(out, text.length());
+            out += text;
+        }
+
+
+        void
+        write_binary_group(const TokenGroup &group, std::string &out)
+        {
+            const TokenList &tokens { group.tokens };
+
+            append_text(out, group.raw);
+            append_varint(out, tokens.size());
+
+            for (std::size_t i { 0 }; i < tokens.size(); i++)
+            {
+                out += static_cast<char>(tokens.get_type(i));
+                append_varint(out, tokens.get_index(i));
+
+                if (tokens.get_type(i) == TokenType::SUB_CONTENT)
+                    write_binary_group(*tokens.get_group(i), out);
+                else
+                    append_text(out, *tokens.get_text(i));
+            }
+        }
+    }
+
+
+    void
+    write_json(const TokenGroup &group, std::string &out)
+    {
+        write_json_group(group, 0, out);
+    }
+
+
+    void
+    write_binary(const TokenGroup &group, std::string &out)
+    {
+        const std::size_t start { out.length() };
+        out.append(sizeof(std::uint32_t), '\0');
+
+        write_binary_group(group, out);
+
+        auto length { static_cast<std::uint32_t>(out.length() - start
+                                                 - sizeof(std::uint32_t)) };
+        for (std::size_t i { 0 }; i < sizeof(std::uint32_t); i++)
+        {
+            out[start + i] = static_cast<char>(length & 0xFF);
+            length >>= 8;
+        }
+    }
+
+
+    void
+    serialize(const TokenGroup &group, OutputFormat format, std::string &out)
+    {
+        switch (format)
+        {
+        case OutputFormat::JSON:
+            write_json(group, out);
+            out += '\n';
+            break;
+
+        case OutputFormat::BINARY: write_binary(group, out); break;
+        }
+    }
+}
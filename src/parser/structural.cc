@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <bit>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "parser/structural.hh"
+
+using parser::StructuralIndex;
+
+
+namespace
+{
+    constexpr std::size_t CLASS_COUNT { StructuralIndex::CLASS_COUNT };
+    constexpr std::size_t BLOCK_SIZE { StructuralIndex::BLOCK_SIZE };
+
+    /* the characters of each class, in the order of the class bits */
+    constexpr std::array<std::string_view, CLASS_COUNT> CLASS_CHARS {
+        " \t\n\v\f\r", "\"", "{", "}", "-!|&;:", "=", "\\",
+    };
+
+
+    [[nodiscard]]
+    constexpr auto
+    make_class_table() -> std::array<std::uint8_t, 256>
+    {
+        std::array<std::uint8_t, 256> table {};
+
+        for (std::size_t c { 0 }; c < CLASS_COUNT; c++)
+            for (const char ch : CLASS_CHARS[c])
+                table[static_cast<unsigned char>(ch)] |= 1 << c;
+
+        return table;
+    }
+
+    constexpr std::array<std::uint8_t, 256> CLASS_TABLE { make_class_table() };
+
+
+    /**
+     * fills @p bits , one bitmap per class, from the BLOCK_SIZE bytes
+     * starting at @p chunk
+     */
+    using classify_func = void (*)(const char *chunk, std::uint64_t *bits);
+
+
+    /* only used where no SIMD version exists */
+    [[maybe_unused]]
+    void
+    classify_scalar(const char *chunk, std::uint64_t *bits)
+    {
+        for (std::size_t i { 0 }; i < BLOCK_SIZE; i++)
+        {
+            const std::uint8_t mask {
+                CLASS_TABLE[static_cast<unsigned char>(chunk[i])]
+            };
+
+            for (std::size_t c { 0 }; c < CLASS_COUNT; c++)
+                bits[c] |= static_cast<std::uint64_t>((mask >> c) & 1) << i;
+        }
+    }
+
+
+#if defined(__x86_64__)
+    [[nodiscard]]
+    auto
+    match_sse2(__m128i bytes, std::string_view chars) -> std::uint64_t
+    {
+        __m128i matches { _mm_setzero_si128() };
+        for (const char ch : chars)
+            matches = _mm_or_si128(matches,
+                                   _mm_cmpeq_epi8(bytes, _mm_set1_epi8(ch)));
+
+        return static_cast<std::uint16_t>(_mm_movemask_epi8(matches));
+    }
+
+
+    void
+    classify_sse2(const char *chunk, std::uint64_t *bits)
+    {
+        for (std::size_t i { 0 }; i < BLOCK_SIZE; i += 16)
+        {
+            const __m128i bytes { _mm_loadu_si128(
+                reinterpret_cast<const __m128i *>(chunk + i)) };
+
+            for (std::size_t c { 0 }; c < CLASS_COUNT; c++)
+                bits[c] |= match_sse2(bytes, CLASS_CHARS[c]) << i;
+        }
+    }
+
+
+    [[nodiscard, gnu::target("avx2")]]
+    auto
+    match_avx2(__m256i bytes, std::string_view chars) -> std::uint64_t
+    {
+        __m256i matches { _mm256_setzero_si256() };
+        for (const char ch : chars)
+            matches = _mm256_or_si256(
+                matches, _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(ch)));
+
+        return static_cast<std::uint32_t>(_mm256_movemask_epi8(matches));
+    }
+
+
+    [[gnu::target("avx2")]]
+    void
+    classify_avx2(const char *chunk, std::uint64_t *bits)
+    {
+        for (std::size_t i { 0 }; i < BLOCK_SIZE; i += 32)
+        {
+            const __m256i bytes { _mm256_loadu_si256(
+                reinterpret_cast<const __m256i *>(chunk + i)) };
+
+            for (std::size_t c { 0 }; c < CLASS_COUNT; c++)
+                bits[c] |= match_avx2(bytes, CLASS_CHARS[c]) << i;
+        }
+    }
+#endif
+
+
+    [[nodiscard]]
+    auto
+    select_classify() -> classify_func
+    {
+#if defined(__x86_64__)
+        /* every x86-64 CPU has SSE2 */
+        if (__builtin_cpu_supports("avx2")) return classify_avx2;
+        return classify_sse2;
+#else
+        return classify_scalar;
+#endif
+    }
+}
+
+
+StructuralIndex::StructuralIndex(std::string_view           text,
+                                 std::pmr::memory_resource *arena)
+    : m_blocks(arena)
+{
+    static const classify_func CLASSIFY { select_classify() };
+
+    const std::size_t full_blocks { text.length() / BLOCK_SIZE };
+    m_blocks.resize((text.length() + BLOCK_SIZE - 1) / BLOCK_SIZE);
+
+    for (std::size_t i { 0 }; i < full_blocks; i++)
+        CLASSIFY(text.data() + i * BLOCK_SIZE, m_blocks[i].bits.data());
+
+    /* the last block is padded with null bytes, which belong to no class */
+    if (full_blocks < m_blocks.size())
+    {
+        std::array<char, BLOCK_SIZE> tail {};
+        std::ranges::copy(text.substr(full_blocks * BLOCK_SIZE), tail.data());
+        CLASSIFY(tail.data(), m_blocks[full_blocks].bits.data());
+    }
+}
+
+
+template <bool T_Invert>
+auto
+StructuralIndex::find_first(std::uint8_t mask,
+                            std::size_t  from,
+                            std::size_t  to) const -> std::size_t
+{
+    if (from >= to) return to;
+
+    auto get_bits { [this, mask](std::size_t block) -> std::uint64_t
+                    {
+                        std::uint64_t bits { 0 };
+                        for (unsigned m { mask }; m != 0; m &= m - 1)
+                            bits |= m_blocks[block].bits[std::countr_zero(m)];
+
+                        return T_Invert ? ~bits : bits;
+                    } };
+
+    std::size_t   block { from / BLOCK_SIZE };
+    std::uint64_t bits { get_bits(block) & (~0ULL << (from % BLOCK_SIZE)) };
+
+    while (bits == 0)
+    {
+        if (++block * BLOCK_SIZE >= to) return to;
+        bits = get_bits(block);
+    }
+
+    return std::min(block * BLOCK_SIZE + std::countr_zero(bits), to);
+}
+
+
+auto
+StructuralIndex::find(std::uint8_t mask, std::size_t from, std::size_t to) const
+    -> std::size_t
+{
+    return find_first<false>(mask, from, to);
+}
+
+
+auto
+StructuralIndex::find_not(std::uint8_t mask,
+                          std::size_t  from,
+                          std::size_t  to) const -> std::size_t
+{
+    return find_first<true>(mask, from, to);
+}
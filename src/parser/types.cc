@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <utility>
 
 #include "parser/error.hh"
@@ -29,7 +30,7 @@ namespace parser
     {
         Json::Value root { Json::objectValue };
 
-        root["raw"]    = this->raw;
+        root["raw"]    = Json::String { this->raw };
         root["tokens"] = Json::arrayValue;
 
         for (const auto &token : this->tokens)
@@ -39,8 +40,8 @@ namespace parser
 
             j_token["data"]
                 = token.type == TokenType::SUB_CONTENT
-                    ? token.get_data<shared_tokens>()->get()->to_json()
-                    : *token.get_data<std::string>();
+                    ? (*token.get_data<TokenGroup *>())->to_json()
+                    : Json::String { *token.get_text() };
             j_token["index"] = token.index;
 
             root["tokens"].append(j_token);
@@ -53,27 +54,590 @@ namespace parser
     auto
     TokenGroup::get_toplevel() const -> const TokenGroup *
     {
-        const TokenGroup *current { this };
-        while (auto parent_ptr { current->parent.lock() })
-            current = parent_ptr.get();
+        return this->toplevel;
+    }
+
+
+    namespace
+    {
+        /**
+         * where the lines of the top-level text start, from a given line on
+         */
+        struct LineStarts
+        {
+            std::vector<std::size_t> starts;
+
+            /* the number of the line starting at the first of @e starts */
+            std::size_t first_line;
+        };
+
+
+        /**
+         * records the position of the tokens [ @p first , @p last ) of
+         * @p group and of the groups they hold, which all start on one of
+         * the lines of @p lines
+         */
+        void
+        set_group_positions(TokenGroup       &group,
+                            std::size_t       first,
+                            std::size_t       last,
+                            const LineStarts &lines)
+        {
+            const auto &starts { lines.starts };
+            const auto  indexes { group.tokens.get_indexes() };
+
+            for (std::size_t i { first }; i < last; i++)
+            {
+                const std::size_t offset { group.offset + indexes[i] };
+                const auto        line { static_cast<std::size_t>(
+                    std::ranges::upper_bound(starts, offset) - starts.begin()
+                    - 1) };
+
+                group.tokens.set_position(
+                    i, { offset, static_cast<std::uint32_t>(lines.first_line
+                                                            + line),
+                         static_cast<std::uint32_t>(offset - starts[line]) });
+
+                if (TokenGroup *child { group.tokens.get_group(i) })
+                    set_group_positions(*child, 0, child->tokens.size(),
+                                        lines);
+            }
+        }
+
+
+        /**
+         * copies @p text into @p arena
+         */
+        [[nodiscard]]
+        auto
+        copy_to_arena(std::pmr::memory_resource *arena, std::string_view text)
+            -> std::string_view
+        {
+            auto *data { static_cast<char *>(
+                arena->allocate(text.length(), alignof(char))) };
+            std::ranges::copy(text, data);
+            return { data, text.length() };
+        }
+    }
+
+
+    TokenList::Iterator::Iterator(const TokenList *list, std::size_t idx)
+        : m_list(list), m_idx(idx)
+    {
+    }
+
+
+    auto
+    TokenList::Iterator::operator*() const -> Token
+    {
+        return (*m_list)[m_idx];
+    }
+
+
+    auto
+    TokenList::Iterator::operator++() -> Iterator &
+    {
+        m_idx++;
+        return *this;
+    }
+
+
+    TokenList::TokenList(std::string_view           text,
+                         std::pmr::memory_resource *arena)
+        : m_text(text), m_arena(arena), m_extra_texts(arena),
+          m_groups(arena), m_operators(arena), m_text_ids(arena)
+    {
+    }
+
+
+    auto
+    TokenList::size() const -> std::size_t
+    {
+        return m_size;
+    }
+
+
+    auto
+    TokenList::empty() const -> bool
+    {
+        return m_size == 0;
+    }
+
+
+    void
+    TokenList::reserve(std::size_t count)
+    {
+        if (count > m_capacity) grow(count);
+    }
+
+
+    void
+    TokenList::append(const TokenList &other,
+                      std::size_t      first,
+                      std::size_t      last,
+                      std::ptrdiff_t   shift)
+    {
+        const std::size_t count { last - first };
+        if (m_size + count > m_capacity)
+            grow(std::max(m_size + count, m_capacity * 2));
+        unshare();
+
+        std::copy_n(other.m_positions + first, count, m_positions + m_size);
+        std::copy_n(other.m_lengths + first, count, m_lengths + m_size);
+        std::copy_n(other.m_types + first, count, m_types + m_size);
+        std::copy_n(other.m_flags + first, count, m_flags + m_size);
+
+        for (std::size_t i { 0 }; i < count; i++)
+        {
+            const std::size_t   from { first + i };
+            const std::uint8_t  flags { other.m_flags[from] };
+            const std::uint32_t offset { other.m_offsets[from] };
+
+            m_indexes[m_size + i] = static_cast<std::uint32_t>(
+                other.m_indexes[from] + shift);
+
+            if ((flags & HOLDS_GROUP) != 0)
+            {
+                m_offsets[m_size + i] = static_cast<std::uint32_t>(
+                    m_groups.size());
+                m_groups.push_back(other.m_groups[offset]);
+            }
+            else if ((offset & EXTRA_TEXT_BIT) != 0)
+            {
+                m_offsets[m_size + i] = static_cast<std::uint32_t>(
+                                            m_extra_texts.size())
+                                      | EXTRA_TEXT_BIT;
+                m_extra_texts.push_back(copy_to_arena(
+                    m_arena, other.m_extra_texts[offset & ~EXTRA_TEXT_BIT]));
+            }
+            else
+                m_offsets[m_size + i] = static_cast<std::uint32_t>(offset
+                                                                   + shift);
+
+            if ((flags & HAS_OPERATOR) != 0)
+                m_operators.emplace_back(m_size + i,
+                                         *other[from].operator_type);
+            if ((flags & HAS_TEXT_ID) != 0)
+                m_text_ids.emplace_back(m_size + i, *other.get_text_id(from));
+        }
+
+        m_size += count;
+    }
+
+
+    void
+    TokenList::share(const TokenList &other)
+    {
+        m_size      = other.m_size;
+        m_capacity  = other.m_size;
+        m_positions = other.m_positions;
+        m_indexes   = other.m_indexes;
+        m_offsets   = other.m_offsets;
+        m_lengths   = other.m_lengths;
+        m_types     = other.m_types;
+        m_flags     = other.m_flags;
+        m_shared    = true;
+
+        m_extra_texts.assign(other.m_extra_texts.begin(),
+                             other.m_extra_texts.end());
+        m_groups.assign(other.m_groups.begin(), other.m_groups.end());
+        m_operators.assign(other.m_operators.begin(),
+                           other.m_operators.end());
+        m_text_ids.assign(other.m_text_ids.begin(), other.m_text_ids.end());
+    }
+
+
+    void
+    TokenList::unshare()
+    {
+        if (m_shared) grow(m_capacity);
+    }
+
+
+    void
+    TokenList::grow(std::size_t capacity)
+    {
+        /* the widest columns come first, so that every column is aligned */
+        auto *block { static_cast<std::byte *>(
+            m_arena->allocate(capacity * TOKEN_SIZE, alignof(Position))) };
+
+        auto move_column { [&]<typename Tp>(Tp *&column) -> void
+                           {
+                               auto *moved { reinterpret_cast<Tp *>(block) };
+                               if (m_size > 0)
+                                   std::copy_n(column, m_size, moved);
+
+                               column  = moved;
+                               block  += capacity * sizeof(Tp);
+                           } };
+
+        move_column(m_positions);
+        move_column(m_indexes);
+        move_column(m_offsets);
+        move_column(m_lengths);
+        move_column(m_types);
+        move_column(m_flags);
+
+        m_capacity = capacity;
+        m_shared   = false;
+    }
+
+
+    auto
+    TokenList::locate_text(std::size_t idx, std::string_view text)
+        -> std::uint32_t
+    {
+        const auto begin { reinterpret_cast<std::uintptr_t>(text.data()) };
+        const auto text_begin { reinterpret_cast<std::uintptr_t>(
+            m_text.data()) };
+
+        if (begin >= text_begin
+            && begin + text.length() <= text_begin + m_text.length())
+            return static_cast<std::uint32_t>(begin - text_begin);
+
+        /* brackets and quotes are literals, the same characters sit
+           at the index of the token */
+        if (m_text.substr(std::min(idx, m_text.length()), text.length())
+            == text)
+            return static_cast<std::uint32_t>(idx);
+
+        m_extra_texts.push_back(text);
+        return static_cast<std::uint32_t>(m_extra_texts.size() - 1)
+             | EXTRA_TEXT_BIT;
+    }
+
+
+    auto
+    TokenList::find_text_id(std::size_t idx)
+        -> decltype(m_text_ids)::iterator
+    {
+        return std::ranges::lower_bound(
+            m_text_ids, idx, {},
+            &std::pair<std::uint32_t, utils::StringPool::id>::first);
+    }
+
+
+    void
+    TokenList::push_back(const Token &token)
+    {
+        std::uint8_t  flags { 0 };
+        std::uint32_t offset { 0 };
+        std::uint32_t length { 0 };
+
+        if (token.starts_step) flags |= STARTS_STEP;
+
+        if (auto text { token.get_text() })
+        {
+            offset = locate_text(token.index, *text);
+            length = static_cast<std::uint32_t>(text->length());
+        }
+        else
+        {
+            flags  |= HOLDS_GROUP;
+            offset  = static_cast<std::uint32_t>(m_groups.size());
+            m_groups.push_back(*token.get_data<TokenGroup *>());
+        }
+
+        if (token.operator_type)
+        {
+            flags |= HAS_OPERATOR;
+            m_operators.emplace_back(m_size, *token.operator_type);
+        }
+
+        if (m_size == m_capacity) grow(std::max<std::size_t>(4, m_size * 2));
+
+        m_types[m_size]     = token.type;
+        m_flags[m_size]     = flags;
+        m_indexes[m_size]   = static_cast<std::uint32_t>(token.index);
+        m_offsets[m_size]   = offset;
+        m_lengths[m_size]   = length;
+        m_positions[m_size] = token.position;
+        m_size++;
+    }
+
+
+    auto
+    TokenList::operator[](std::size_t idx) const -> Token
+    {
+        Token token {};
+        token.type        = m_types[idx];
+        token.index       = m_indexes[idx];
+        token.position    = m_positions[idx];
+        token.starts_step = (m_flags[idx] & STARTS_STEP) != 0;
+
+        if (auto text { get_text(idx) })
+            token.data = *text;
+        else
+            token.data = get_group(idx);
+
+        if ((m_flags[idx] & HAS_OPERATOR) != 0)
+            token.operator_type = std::ranges::lower_bound(
+                                      m_operators, idx, {},
+                                      &std::pair<std::uint32_t,
+                                                 OperatorType>::first)
+                                      ->second;
+
+        return token;
+    }
+
+
+    auto
+    TokenList::front() const -> Token
+    {
+        return (*this)[0];
+    }
+
+
+    auto
+    TokenList::begin() const -> Iterator
+    {
+        return { this, 0 };
+    }
+
+
+    auto
+    TokenList::end() const -> Iterator
+    {
+        return { this, size() };
+    }
+
+
+    auto
+    TokenList::get_type(std::size_t idx) const -> TokenType
+    {
+        return m_types[idx];
+    }
+
+
+    auto
+    TokenList::get_index(std::size_t idx) const -> std::size_t
+    {
+        return m_indexes[idx];
+    }
+
+
+    auto
+    TokenList::starts_step(std::size_t idx) const -> bool
+    {
+        return (m_flags[idx] & STARTS_STEP) != 0;
+    }
+
+
+    auto
+    TokenList::get_text(std::size_t idx) const
+        -> std::optional<std::string_view>
+    {
+        if ((m_flags[idx] & HOLDS_GROUP) != 0) return std::nullopt;
+
+        const std::uint32_t offset { m_offsets[idx] };
+        if ((offset & EXTRA_TEXT_BIT) != 0)
+            return m_extra_texts[offset & ~EXTRA_TEXT_BIT];
+
+        return m_text.substr(offset, m_lengths[idx]);
+    }
+
+
+    auto
+    TokenList::get_group(std::size_t idx) const -> TokenGroup *
+    {
+        if ((m_flags[idx] & HOLDS_GROUP) == 0) return nullptr;
+        return m_groups[m_offsets[idx]];
+    }
+
+
+    auto
+    TokenList::get_text_id(std::size_t idx) const
+        -> std::optional<utils::StringPool::id>
+    {
+        if ((m_flags[idx] & HAS_TEXT_ID) == 0) return std::nullopt;
+
+        return std::ranges::lower_bound(
+                   m_text_ids, idx, {},
+                   &std::pair<std::uint32_t, utils::StringPool::id>::first)
+            ->second;
+    }
+
+
+    auto
+    TokenList::get_types() const -> std::span<const TokenType>
+    {
+        return { m_types, m_size };
+    }
+
+
+    auto
+    TokenList::get_indexes() const -> std::span<const std::uint32_t>
+    {
+        return { m_indexes, m_size };
+    }
+
+
+    auto
+    TokenList::get_positions() const -> std::span<const Position>
+    {
+        return { m_positions, m_size };
+    }
+
+
+    auto
+    TokenList::get_lengths() const -> std::span<const std::uint32_t>
+    {
+        return { m_lengths, m_size };
+    }
+
+
+    void
+    TokenList::set_starts_step(std::size_t idx)
+    {
+        unshare();
+        m_flags[idx] |= STARTS_STEP;
+    }
+
+
+    void
+    TokenList::set_position(std::size_t idx, const Position &position)
+    {
+        unshare();
+        m_positions[idx] = position;
+    }
+
+
+    void
+    TokenList::set_text(std::size_t idx, std::string_view text)
+    {
+        unshare();
+        m_flags[idx]   &= ~HOLDS_GROUP;
+        m_offsets[idx]  = locate_text(m_indexes[idx], text);
+        m_lengths[idx]  = static_cast<std::uint32_t>(text.length());
+
+        if ((m_flags[idx] & HAS_TEXT_ID) == 0) return;
+
+        m_flags[idx] &= ~HAS_TEXT_ID;
+        m_text_ids.erase(find_text_id(idx));
+    }
+
+
+    void
+    TokenList::set_text_id(std::size_t idx, utils::StringPool::id text_id)
+    {
+        unshare();
+
+        /* the lexer gives the ids in order, as the tokens are added */
+        if (m_text_ids.empty() || m_text_ids.back().first < idx)
+        {
+            m_flags[idx] |= HAS_TEXT_ID;
+            m_text_ids.emplace_back(idx, text_id);
+            return;
+        }
+
+        auto it { find_text_id(idx) };
+        if ((m_flags[idx] & HAS_TEXT_ID) != 0)
+        {
+            it->second = text_id;
+            return;
+        }
+
+        m_flags[idx] |= HAS_TEXT_ID;
+        m_text_ids.insert(it, { static_cast<std::uint32_t>(idx), text_id });
+    }
+
+
+    void
+    TokenList::set_group(std::size_t idx, TokenGroup *group)
+    {
+        m_groups[m_offsets[idx]] = group;
+    }
+
+
+    auto
+    TokenList::get_allocator() const -> std::pmr::polymorphic_allocator<>
+    {
+        return m_arena;
+    }
+
 
-        return current;
+    TokenGroup::TokenGroup(std::string_view           raw,
+                           std::string_view           source,
+                           TokenGroup                *parent,
+                           std::pmr::memory_resource *arena)
+        : tokens(raw, arena), raw(raw), source(source), parent(parent),
+          toplevel(parent != nullptr ? parent->toplevel : this),
+          tree(parent != nullptr ? parent->tree : nullptr)
+    {
     }
 
 
-    TokenGroup::TokenGroup(std::string raw, const shared_tokens &parent)
-        : tokens({}), raw(std::move(raw)), source("stdin"), parent(parent)
+    void
+    TokenGroup::set_positions()
     {
+        set_positions(0, this->tokens.size(), {});
     }
 
 
-    Token::Token(TokenType type, std::size_t idx, std::string data)
-        : type(type), index(idx), data(std::move(data))
+    void
+    TokenGroup::set_positions(std::size_t     first,
+                              std::size_t     last,
+                              const Position &from)
     {
+        /* the groups held by the tokens end before the next token */
+        const std::size_t end { last < this->tokens.size()
+                                    ? this->tokens.get_index(last)
+                                    : this->raw.length() };
+
+        LineStarts lines { { from.offset - from.column }, from.line };
+        for (std::size_t i { this->raw.find('\n', lines.starts.front()) };
+             i < end; i = this->raw.find('\n', i + 1))
+            lines.starts.push_back(i + 1);
+
+        set_group_positions(*this, first, last, lines);
     }
 
 
-    Token::Token(TokenType type, std::size_t idx, const shared_tokens &data)
+    void
+    TokenGroup::replace_raw(std::size_t      pos,
+                            std::size_t      count,
+                            std::string_view replacement)
+    {
+        /* the old text stays in the arena, the tokens may still view it */
+        std::string text { this->raw };
+        text.replace(pos, count, replacement);
+
+        this->raw = copy_text(text);
+    }
+
+
+    auto
+    TokenGroup::make_child(std::string_view raw) -> TokenGroup *
+    {
+        std::pmr::polymorphic_allocator<> allocator {
+            this->tokens.get_allocator()
+        };
+        return allocator.new_object<TokenGroup>(raw, this->source, this,
+                                                allocator.resource());
+    }
+
+
+    auto
+    TokenGroup::copy_text(std::string_view text) -> std::string_view
+    {
+        return copy_to_arena(this->tokens.get_allocator().resource(), text);
+    }
+
+
+    void
+    TokenGroup::set_text(std::size_t idx, std::string_view text)
+    {
+        this->tokens.set_text(idx, copy_text(text));
+    }
+
+
+    Token::Token(TokenType type, std::size_t idx, std::string_view data)
+        : type(type), index(idx), data(data)
+    {
+    }
+
+
+    Token::Token(TokenType type, std::size_t idx, TokenGroup *data)
         : type(type), index(idx), data(data)
     {
     }
@@ -88,9 +652,74 @@ namespace parser
     }
 
 
+    auto
+    Token::get_text() const -> std::optional<std::string_view>
+    {
+        if (const auto *text { this->get_data<std::string_view>() })
+            return *text;
+        return std::nullopt;
+    }
+
+
     auto
     Token::get_highlighted() const -> std::string
     {
         return "";
     }
+
+
+    TokenTree::TokenTree(std::string_view source,
+                         std::string_view text,
+                         std::size_t      first_line)
+        : m_initial_buffer(), m_first_line(first_line)
+    {
+        /* about two tokens per byte of text, including the space lost
+           to growing the token lists */
+        const std::size_t estimate { INITIAL_ARENA_OVERHEAD
+                                     + text.length() * 2
+                                           * (TokenList::TOKEN_SIZE
+                                              + sizeof(TokenGroup *)) };
+
+        if (estimate <= m_initial_buffer.size())
+            m_arena.emplace(m_initial_buffer.data(), m_initial_buffer.size());
+        else
+            m_arena.emplace(estimate);
+
+        std::pmr::polymorphic_allocator<> allocator { &*m_arena };
+        m_root = allocator.new_object<TokenGroup>(
+            copy_to_arena(&*m_arena, text), copy_to_arena(&*m_arena, source),
+            nullptr, &*m_arena);
+        m_root->tree = this;
+    }
+
+
+    auto
+    TokenTree::get_root() -> TokenGroup *
+    {
+        return m_root;
+    }
+
+
+    auto
+    TokenTree::get_first_line() const -> std::size_t
+    {
+        return m_first_line;
+    }
+
+
+    void
+    TokenTree::keep_alive(const std::shared_ptr<const TokenGroup> &tokens)
+    {
+        const auto &kept { tokens->tree->m_kept_alive };
+
+        m_kept_alive.insert(m_kept_alive.end(), kept.begin(), kept.end());
+        m_kept_alive.push_back(tokens);
+    }
+
+
+    auto
+    TokenTree::get_kept_alive_count() const -> std::size_t
+    {
+        return m_kept_alive.size();
+    }
 }
@@ -1,7 +1,13 @@
+#include <map>
+#include <memory>
+#include <mutex>
 #include <stack>
 
+#include <sys/stat.h>
+
 #include "command/built_in.hh"
 #include "command/runner.hh"
+#include "lru_cache.hh"
 #include "parser/error.hh"
 #include "parser/types.hh"
 
@@ -13,39 +19,101 @@ namespace parser
 {
     namespace
     {
+        /**
+         * the entries of a directory at the time it was last modified
+         */
+        struct DirectoryListing
+        {
+            timespec                                        mtime;
+            std::shared_ptr<const std::vector<std::string>> names;
+        };
+
+        constexpr std::size_t MAX_CACHED_LISTINGS { 64 };
+
+        /* directory listings keyed by the device and inode of the directory */
+        std::map<std::pair<dev_t, ino_t>, DirectoryListing> LISTING_CACHE;
+        std::mutex                                          LISTING_MUTEX;
+
+
+        /**
+         * get the names of the entries inside @p dir
+         * ------------------------------------------
+         *
+         * a listing is reused as long as the modification time of @p dir
+         * does not change, which is the case whenever an entry is added,
+         * removed or renamed
+         *
+         * the listing is shared, so it stays valid even if the cache drops
+         * it while another thread still reads it
+         *
+         * @throw std::filesystem::filesystem_error on failure
+         */
         [[nodiscard]]
         auto
-        collect_paths(const fs::path &dir) -> std::vector<fs::path>
+        collect_paths(const fs::path &dir)
+            -> std::shared_ptr<const std::vector<std::string>>
         {
-            std::vector<fs::path> paths;
+            struct stat st {};
+            if (stat(dir.c_str(), &st) != 0)
+                throw fs::filesystem_error {
+                    "failed to stat directory", dir,
+                    std::error_code { errno, std::system_category() }
+                };
+
+            const std::pair key { st.st_dev, st.st_ino };
+
+            {
+                std::scoped_lock lock { LISTING_MUTEX };
+
+                if (auto it { LISTING_CACHE.find(key) };
+                    it != LISTING_CACHE.end()
+                    && it->second.mtime.tv_sec == st.st_mtim.tv_sec
+                    && it->second.mtime.tv_nsec == st.st_mtim.tv_nsec)
+                    return it->second.names;
+            }
+
+            /* listed without the lock, two threads may list the same
+               directory but neither waits on the other's disk access */
+            auto names { std::make_shared<std::vector<std::string>>() };
+            for (const auto &entry : fs::directory_iterator { dir })
+                names->emplace_back(entry.path().filename().string());
+
+            std::scoped_lock lock { LISTING_MUTEX };
 
-            fs::directory_iterator it { dir };
-            for (const auto &entry : it)
-                paths.emplace_back(fs::relative(fs::canonical(entry.path())));
-            return paths;
+            if (LISTING_CACHE.size() >= MAX_CACHED_LISTINGS
+                && !LISTING_CACHE.contains(key))
+                LISTING_CACHE.clear();
+
+            LISTING_CACHE[key] = { st.st_mtim, names };
+            return names;
         }
 
 
         [[nodiscard]]
         auto
-        find_closest_path(const std::vector<fs::path> &paths,
-                          const fs::path &path) -> std::pair<fs::path, int>
+        find_closest_path(const std::vector<std::string> &names,
+                          const fs::path                 &path,
+                          int max_distance) -> std::pair<fs::path, int>
         {
+            const std::vector<std::string_view> candidates { names.begin(),
+                                                             names.end() };
+            const std::vector<int> distances {
+                utils::str::bounded_levenshtein_distance(
+                    path.string(), candidates, max_distance)
+            };
+
             int      smallest { std::numeric_limits<int>::max() };
             fs::path closest;
 
-            for (const auto &candidate : paths)
+            for (std::size_t i { 0 }; i < distances.size(); i++)
             {
-                fs::path filename { candidate.filename() };
-                int dist { utils::str::levenshtein_distance(filename.string(),
-                                                            path.string()) };
-                if (dist < smallest)
+                if (distances[i] < smallest)
                 {
-                    closest  = filename;
-                    smallest = dist;
+                    closest  = names[i];
+                    smallest = distances[i];
                 }
 
-                if (dist == 0) break;
+                if (distances[i] == 0) break;
             }
 
             return { closest, smallest };
@@ -67,20 +135,21 @@ namespace parser
 
             for (std::size_t i { 0 }; i < segments.size(); i++)
             {
-                std::vector<fs::path> children;
+                int min_distance { 2 + static_cast<int>(segments.size() * 2) };
+
+                std::pair<fs::path, int> closest_path;
                 try
                 {
-                    children = collect_paths(current_path);
+                    closest_path = find_closest_path(
+                        *collect_paths(current_path), segments[i],
+                        min_distance);
                 }
                 catch (...)
                 {
                     return {};
                 }
 
-                auto [closest,
-                      distance] { find_closest_path(children, segments[i]) };
-
-                int min_distance { 2 + static_cast<int>(segments.size() * 2) };
+                auto [closest, distance] { closest_path };
                 if (distance > min_distance) return {};
 
                 current_path /= closest;
@@ -95,10 +164,12 @@ namespace parser
 
         [[nodiscard]]
         auto
-        handle_path_verification(TokenGroup &tokens, Token &front)
+        handle_path_verification(TokenGroup &tokens,
+                                 const Token &front,
+                                 bool        interactive)
             -> std::pair<bool, std::optional<::error::Info>>
         {
-            const std::string text { *front.get_data<std::string>() };
+            const std::string text { *front.get_text() };
 
             if (!text.starts_with("./")) return { false, std::nullopt };
             fs::path path { text.substr(2) };
@@ -124,6 +195,8 @@ namespace parser
             auto err { error::create<error::Type::INVALID_COMMAND>(
                 tokens, front, "executable path '{}' doesn't exist", text) };
 
+            if (!interactive) return { false, err };
+
             fs::path match { find_nearest_looking_path(path) };
             if (match.empty()) return { false, err };
 
@@ -136,91 +209,184 @@ namespace parser
 
             if (std::size_t it { tokens.raw.find(text) };
                 it != std::string::npos)
-                tokens.raw.replace(it, matched_path.length(), matched_path);
+                tokens.replace_raw(it, matched_path.length(), matched_path);
 
-            path       = match;
-            front.data = matched_path;
+            path = match;
+            tokens.set_text(0, matched_path);
             return { true, std::nullopt };
         }
 
 
+        enum class Verdict : std::uint8_t
+        {
+            EXISTS,
+            SUGGESTION,
+            NO_SUGGESTION,
+        };
+
+
+        struct CommandVerdict
+        {
+            Verdict     verdict;
+            std::string suggestion;
+
+            /* the command, to tell apart the commands of the same hash */
+            std::string command;
+
+            /* the binary path list generation the verdict was made with */
+            std::uint64_t generation;
+        };
+
+        constexpr std::size_t MAX_CACHED_VERDICTS { 256 };
+
+        /* keyed by the hash of the command, which is not interned, so
+           that misspelled commands do not pin memory for the session */
+        utils::LruCache<std::size_t, CommandVerdict> VERDICT_CACHE {
+            MAX_CACHED_VERDICTS
+        };
+        std::mutex VERDICT_MUTEX;
+
+
+        /**
+         * checks whether @p text names an executable, and if not,
+         * looks for the closest command to suggest instead
+         */
         [[nodiscard]]
         auto
-        handle_command_verification(TokenGroup &tokens, Token &front)
-            -> std::pair<bool, std::optional<::error::Info>>
+        make_command_verdict(const std::string &text) -> CommandVerdict
         {
-            const std::string text { *front.get_data<std::string>() };
+            if (cmd::binary_exists(text))
+                return { Verdict::EXISTS, {}, text, 0 };
 
-            if (!cmd::BINARY_PATH_LIST.contains(text)
-                && !cmd::built_in::COMMANDS.contains(text))
+            int         smallest { std::numeric_limits<int>::max() };
+            std::string bin_name;
+            for (const auto &[name, func] : cmd::built_in::COMMANDS)
             {
-                auto err { error::create<error::Type::INVALID_COMMAND>(
-                    tokens, front, "command '{}' doesn't exist", text) };
-
-                int         smallest { std::numeric_limits<int>::max() };
-                std::string bin_name;
-                for (const auto &[name, func] : cmd::built_in::COMMANDS)
+                int dist { utils::str::bounded_levenshtein_distance(
+                    name, text, 2) };
+                if (dist < smallest)
                 {
-                    int dist { utils::str::levenshtein_distance(name, text) };
-                    if (dist < smallest)
-                    {
-                        smallest = dist;
-                        bin_name = name;
-                    }
+                    smallest = dist;
+                    bin_name = name;
                 }
+            }
 
-                for (const auto &[name, path] : cmd::BINARY_PATH_LIST)
+            const auto binary_paths { cmd::get_binary_path_list() };
+            for (const auto &[name, dist] :
+                 binary_paths->find_similar(text, 2))
+            {
+                if (dist < smallest || (dist == smallest && name < bin_name))
                 {
-                    int dist { utils::str::levenshtein_distance(name, text) };
-                    if (dist < smallest)
-                    {
-                        smallest = dist;
-                        bin_name = name;
-                    }
+                    smallest = dist;
+                    bin_name = name;
                 }
+            }
+
+            if (smallest > 2) return { Verdict::NO_SUGGESTION, {}, text, 0 };
+            return { Verdict::SUGGESTION, bin_name, text, 0 };
+        }
+
+
+        /**
+         * get the verdict of @p text , which is only recomputed when
+         * the binary path list changed since it was last made
+         */
+        [[nodiscard]]
+        auto
+        get_command_verdict(const std::string &text) -> CommandVerdict
+        {
+            const std::size_t hash { std::hash<std::string_view> {}(text) };
+
+            /* read before the verdict is made, so that a list published
+               in the meantime invalidates it */
+            const std::uint64_t generation {
+                cmd::get_binary_path_generation()
+            };
+
+            {
+                std::scoped_lock lock { VERDICT_MUTEX };
 
-                if (smallest > 2) return { true, err };
-                char res { ::error::ask<'y', 'y', 'n'>(
-                    "command '{}' doesn't exist, do you mean '{}'?", text,
-                    bin_name) };
+                if (auto *cached { VERDICT_CACHE.find(hash) };
+                    cached != nullptr && cached->generation == generation
+                    && cached->command == text)
+                    return *cached;
+            }
 
-                if (res != 'y') return { true, err };
-                front.data = bin_name;
+            CommandVerdict verdict { make_command_verdict(text) };
+            verdict.generation = generation;
 
-                return { true, std::nullopt };
+            /* before the first list is published, commands are resolved
+               in a way that the generation does not keep track of */
+            if (generation != 0)
+            {
+                std::scoped_lock lock { VERDICT_MUTEX };
+                VERDICT_CACHE.insert(hash, verdict);
             }
 
-            return { false, std::nullopt };
+            return verdict;
         }
 
 
         [[nodiscard]]
         auto
-        verify_command(TokenGroup &tokens, Token &front)
+        handle_command_verification(TokenGroup &tokens,
+                                    const Token &front,
+                                    bool        interactive)
+            -> std::pair<bool, std::optional<::error::Info>>
+        {
+            const std::string text { *front.get_text() };
+
+            /* built-ins are known without waiting for the $PATH scan */
+            if (cmd::built_in::COMMANDS.contains(text))
+                return { false, std::nullopt };
+
+            const CommandVerdict verdict { get_command_verdict(text) };
+            if (verdict.verdict == Verdict::EXISTS)
+                return { false, std::nullopt };
+
+            auto err { error::create<error::Type::INVALID_COMMAND>(
+                tokens, front, "command '{}' doesn't exist", text) };
+
+            if (verdict.verdict == Verdict::NO_SUGGESTION || !interactive)
+                return { true, err };
+
+            char res { ::error::ask<'y', 'y', 'n'>(
+                "command '{}' doesn't exist, do you mean '{}'?", text,
+                verdict.suggestion) };
+
+            if (res != 'y') return { true, err };
+            tokens.set_text(0, verdict.suggestion);
+
+            return { true, std::nullopt };
+        }
+
+
+        [[nodiscard]]
+        auto
+        verify_command(TokenGroup &tokens, const Token &front, bool interactive)
             -> std::optional<::error::Info>
         {
-            auto err { handle_path_verification(tokens, front) };
+            auto err { handle_path_verification(tokens, front, interactive) };
             if (err.first) return err.second;
 
-            return handle_command_verification(tokens, front).second;
+            return handle_command_verification(tokens, front, interactive)
+                .second;
         }
 
 
         [[nodiscard]]
         auto
-        check_string_quote_token(TokenGroup  &tokens,
-                                 std::size_t &quote_idx,
-                                 std::size_t  idx)
+        check_string_quote_token(const TokenGroup &tokens,
+                                 std::size_t      &quote_idx,
+                                 std::size_t       idx)
             -> std::optional<::error::Info>
         {
-            const auto &token { tokens.tokens[idx] };
-
-            if (token.type == TokenType::STRING_QUOTE)
+            if (tokens.tokens.get_type(idx) == TokenType::STRING_QUOTE)
             {
                 if (quote_idx != std::string::npos)
                 {
                     if (quote_idx + 1 < tokens.tokens.size()
-                        && tokens.tokens[quote_idx + 1].type
+                        && tokens.tokens.get_type(quote_idx + 1)
                                != TokenType::STRING_CONTENT)
                     {
                         return error::create<error::Type::EMPTY_STRING>(
@@ -238,24 +404,22 @@ namespace parser
 
         [[nodiscard]]
         auto
-        check_substitution_bracket_token(TokenGroup              &tokens,
+        check_substitution_bracket_token(const TokenGroup        &tokens,
                                          std::stack<std::size_t> &bracket_stack,
                                          std::size_t              idx)
             -> std::optional<::error::Info>
         {
-            const auto &token { tokens.tokens[idx] };
-
-            if (token.type == TokenType::SUB_BRACKET)
+            if (tokens.tokens.get_type(idx) == TokenType::SUB_BRACKET)
             {
-                const std::string *text { token.get_data<std::string>() };
-                const char         bracket { (*text)[0] };
+                const std::string_view text { *tokens.tokens.get_text(idx) };
+                const char             bracket { text[0] };
 
                 if (bracket == '{')
                 {
                     bracket_stack.push(idx);
 
                     if (idx + 1 < tokens.tokens.size()
-                        && tokens.tokens[idx + 1].type
+                        && tokens.tokens.get_type(idx + 1)
                                != TokenType::SUB_CONTENT)
                     {
                         return error::create<error::Type::EMPTY_SUBSTITUTION>(
@@ -283,13 +447,13 @@ namespace parser
 
         [[nodiscard]]
         auto
-        check_parameter_token(TokenGroup &tokens, std::size_t idx)
+        check_parameter_token(const TokenGroup &tokens, std::size_t idx)
             -> std::optional<::error::Info>
         {
-            if (tokens.tokens[idx].type != TokenType::PARAMETER)
+            if (tokens.tokens.get_type(idx) != TokenType::PARAMETER)
                 return std::nullopt;
 
-            const auto *text { tokens.tokens[idx].get_data<std::string>() };
+            const auto text { tokens.tokens.get_text(idx) };
 
             if (!text->empty()) return std::nullopt;
 
@@ -300,15 +464,13 @@ namespace parser
 
         [[nodiscard]]
         auto
-        check_arithmetic_token(TokenGroup &tokens, std::size_t idx)
+        check_arithmetic_token(const TokenGroup &tokens, std::size_t idx)
             -> std::optional<::error::Info>
         {
-            const auto &token { tokens.tokens[idx] };
-
-            if (token.type == TokenType::ARITHMETIC_BRACKET)
+            if (tokens.tokens.get_type(idx) == TokenType::ARITHMETIC_BRACKET)
             {
                 if (tokens.tokens.size() > idx + 1)
-                    if (tokens.tokens[idx + 1].type
+                    if (tokens.tokens.get_type(idx + 1)
                         != TokenType::ARITHMETIC_EXPRESSION)
                         return error::create<
                             error::Type::EMPTY_ARITHMETIC_EXPRESSION>(
@@ -317,18 +479,15 @@ namespace parser
 
                 if (tokens.tokens.size() > idx + 2)
                 {
-                    const auto &token { tokens.tokens[idx + 2] };
-
-                    if (token.type != TokenType::ARITHMETIC_BRACKET)
+                    if (tokens.tokens.get_type(idx + 2)
+                        != TokenType::ARITHMETIC_BRACKET)
                         return error::create<error::Type::UNCLOSED_BRACKET>(
                             tokens, tokens.tokens[idx],
                             "arithmetic expression's bracket is not closed");
 
-                    const std::string *bracket {
-                        token.get_data<std::string>()
-                    };
+                    const auto bracket { tokens.tokens.get_text(idx + 2) };
 
-                    if (bracket == nullptr || *bracket != "}}")
+                    if (bracket != "}}")
                         return error::create<error::Type::INVALID_BRACKET>(
                             tokens, tokens.tokens[idx + 2],
                             "arithmetic expression must be closed with a "
@@ -345,50 +504,136 @@ namespace parser
     }
 
 
-    auto
-    TokenGroup::verify_syntax() -> std::optional<::error::Info>
+    namespace
     {
-        using enum TokenType;
+        /**
+         * checks the tokens of @p group and of the groups it holds, in
+         * the order verify_syntax() reaches them, @p entered counts the
+         * groups entered so far
+         */
+        [[nodiscard]]
+        auto
+        check_group_syntax(const TokenGroup &group, std::size_t &entered)
+            -> std::optional<::error::Info>
+        {
+            entered++;
 
-        if (auto err { verify_command(*this, this->tokens.front()) })
-            return err;
+            std::stack<std::size_t> bracket_stack;
+            std::size_t             quote_idx { std::string::npos };
+
+            for (std::size_t i { 1 }; i < group.tokens.size(); i++)
+            {
+                if (const TokenGroup *child { group.tokens.get_group(i) })
+                {
+                    auto res { check_group_syntax(*child, entered) };
+                    if (res) return res;
+                }
+
+                auto res { check_parameter_token(group, i) };
+                if (res) return res;
+
+                res = check_string_quote_token(group, quote_idx, i);
+                if (res) return res;
+
+                res = check_substitution_bracket_token(group, bracket_stack, i);
+                if (res) return res;
+
+                res = check_arithmetic_token(group, i);
+                if (res) return res;
+            }
+
+            if (!bracket_stack.empty())
+                return error::create<error::Type::UNCLOSED_BRACKET>(
+                    group, group.tokens[bracket_stack.top()],
+                    "unclosed bracket");
 
-        std::stack<std::size_t> bracket_stack;
-        std::size_t             quote_idx { std::string::npos };
+            if (quote_idx != std::string::npos)
+                return error::create<error::Type::UNCLOSED_QUOTE>(
+                    group, group.tokens[quote_idx], "unclosed quote");
 
-        for (std::size_t i { 1 }; i < this->tokens.size(); i++)
+            return std::nullopt;
+        }
+
+
+        /**
+         * checks the commands of @p group and of the groups it holds in
+         * preorder, until @p remaining groups have been checked
+         */
+        [[nodiscard]]
+        auto
+        verify_group_commands(TokenGroup  &group,
+                              bool         interactive,
+                              std::size_t &remaining)
+            -> std::optional<::error::Info>
         {
-            if (this->tokens[i].type == SUB_CONTENT)
+            if (remaining == 0) return std::nullopt;
+            remaining--;
+
+            if (auto err { verify_command(group, group.tokens.front(),
+                                          interactive) })
+                return err;
+
+            for (std::size_t i { 1 }; i < group.tokens.size() && remaining > 0;
+                 i++)
             {
-                auto res { this->tokens[i]
-                               .get_data<shared_tokens>()
-                               ->get()
-                               ->verify_syntax() };
-                if (res) return res;
+                TokenGroup *child { group.tokens.get_group(i) };
+                if (child == nullptr) continue;
+
+                if (auto err { verify_group_commands(*child, interactive,
+                                                     remaining) })
+                    return err;
             }
 
-            auto res { check_parameter_token(*this, i) };
-            if (res) return res;
+            return std::nullopt;
+        }
+    }
+
 
-            res = check_string_quote_token(*this, quote_idx, i);
-            if (res) return res;
+    auto
+    is_valid_command(std::string_view text) -> bool
+    {
+        const std::string command { text };
 
-            res = check_substitution_bracket_token(*this, bracket_stack, i);
-            if (res) return res;
+        if (command.starts_with("./"))
+        {
+            std::error_code ec;
+            const fs::path  path { command.substr(2) };
 
-            res = check_arithmetic_token(*this, i);
-            if (res) return res;
+            return fs::is_regular_file(path, ec)
+                && access(path.c_str(), X_OK) == 0;
         }
 
-        if (!bracket_stack.empty())
-            return error::create<error::Type::UNCLOSED_BRACKET>(
-                *this, tokens[bracket_stack.top()], "unclosed bracket");
+        if (cmd::built_in::COMMANDS.contains(command)) return true;
+        return get_command_verdict(command).verdict == Verdict::EXISTS;
+    }
+
+
+    auto
+    TokenGroup::check_syntax() const -> SyntaxCheck
+    {
+        SyntaxCheck result;
+        result.error = check_group_syntax(*this, result.entered_groups);
+        return result;
+    }
+
+
+    auto
+    TokenGroup::verify_syntax(bool interactive) -> std::optional<::error::Info>
+    {
+        return verify_syntax(interactive, check_syntax());
+    }
 
-        if (quote_idx != std::string::npos)
-            return error::create<error::Type::UNCLOSED_QUOTE>(
-                *this, tokens[quote_idx], "unclosed quote");
 
+    /* the commands of a group are checked as soon as it is entered, so
+       the ones entered before the syntax error come first */
+    auto
+    TokenGroup::verify_syntax(bool interactive, const SyntaxCheck &syntax)
+        -> std::optional<::error::Info>
+    {
+        std::size_t remaining { syntax.entered_groups };
+        if (auto err { verify_group_commands(*this, interactive, remaining) })
+            return err;
 
-        return std::nullopt;
+        return syntax.error;
     }
 }
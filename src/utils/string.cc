@@ -1,9 +1,194 @@
 #include <algorithm>
+#include <array>
+#include <cstdint>
 #include <format>
 
 #include "utils.hh"
 
 
+namespace
+{
+    constexpr std::size_t MAX_PATTERN_LENGTH { 64 };
+    constexpr std::size_t LANES { 4 };
+
+    using u64x4 = std::uint64_t __attribute__((vector_size(32)));
+    using i64x4 = std::int64_t __attribute__((vector_size(32)));
+
+    /* for each byte, the positions it occupies inside the pattern */
+    using peq_table = std::array<std::uint64_t, 256>;
+
+
+    [[nodiscard]]
+    auto
+    make_peq_table(std::string_view pattern) -> peq_table
+    {
+        peq_table peq {};
+        for (std::size_t i { 0 }; i < pattern.length(); i++)
+            peq[static_cast<unsigned char>(pattern[i])] |= 1ULL << i;
+        return peq;
+    }
+
+
+    /**
+     * Hyyrö's formulation of Myers' bit-parallel edit distance,
+     * the pattern must be between 1 and 64 bytes long
+     */
+    [[nodiscard]]
+    auto
+    myers_distance(const peq_table &peq,
+                   std::size_t      pattern_len,
+                   std::string_view text,
+                   int              max) -> int
+    {
+        const std::uint64_t high_bit { 1ULL << (pattern_len - 1) };
+        const auto          text_len { static_cast<int>(text.length()) };
+
+        std::uint64_t pv { ~0ULL };
+        std::uint64_t mv { 0 };
+        int           score { static_cast<int>(pattern_len) };
+
+        for (int j { 0 }; j < text_len; j++)
+        {
+            const std::uint64_t eq { peq[static_cast<unsigned char>(text[j])] };
+
+            const std::uint64_t xv { eq | mv };
+            const std::uint64_t xh { (((eq & pv) + pv) ^ pv) | eq };
+
+            std::uint64_t ph { mv | ~(xh | pv) };
+            std::uint64_t mh { pv & xh };
+
+            if ((ph & high_bit) != 0)
+                score++;
+            else if ((mh & high_bit) != 0)
+                score--;
+
+            /* the first row of the matrix is 0, 1, 2, ... */
+            ph = (ph << 1) | 1;
+            mh <<= 1;
+
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+
+            /* each remaining column lowers the score by at most one */
+            if (score - (text_len - j - 1) > max) return max + 1;
+        }
+
+        return std::min(score, max + 1);
+    }
+
+
+    /**
+     * the regular two-row dynamic programming distance, which stops
+     * once a whole row exceeds @p max
+     */
+    [[nodiscard]]
+    auto
+    row_distance(std::string_view a, std::string_view b, int max) -> int
+    {
+        std::vector<int> prev(b.length() + 1);
+        std::vector<int> curr(b.length() + 1);
+
+        for (std::size_t j { 0 }; j <= b.length(); j++)
+            prev[j] = static_cast<int>(j);
+
+        for (std::size_t i { 1 }; i <= a.length(); i++)
+        {
+            curr[0] = static_cast<int>(i);
+            int row_min { curr[0] };
+
+            for (std::size_t j { 1 }; j <= b.length(); j++)
+            {
+                int cost { (a[i - 1] == b[j - 1]) ? 0 : 1 };
+                curr[j] = std::min(
+                    { prev[j] + 1, curr[j - 1] + 1, prev[j - 1] + cost });
+                row_min = std::min(row_min, curr[j]);
+            }
+
+            if (row_min > max) return max + 1;
+            std::swap(prev, curr);
+        }
+
+        return std::min(prev[b.length()], max + 1);
+    }
+
+
+    /**
+     * runs myers_distance() on up to LANES candidates at once
+     */
+    void
+    myers_distance_lanes(const peq_table                  &peq,
+                         std::size_t                       pattern_len,
+                         std::span<const std::string_view> texts,
+                         int                               max,
+                         int                              *results)
+    {
+        const auto high_shift { static_cast<std::int64_t>(pattern_len - 1) };
+
+        i64x4       len {};
+        std::size_t max_len { 0 };
+        for (std::size_t i { 0 }; i < texts.size(); i++)
+        {
+            len[i]  = static_cast<std::int64_t>(texts[i].length());
+            max_len = std::max(max_len, texts[i].length());
+        }
+
+        u64x4 pv { ~0ULL, ~0ULL, ~0ULL, ~0ULL };
+        u64x4 mv {};
+        i64x4 score { high_shift + 1, high_shift + 1, high_shift + 1,
+                      high_shift + 1 };
+
+        for (std::size_t j { 0 }; j < max_len; j++)
+        {
+            u64x4 eq {};
+            for (std::size_t i { 0 }; i < texts.size(); i++)
+                if (j < texts[i].length())
+                    eq[i] = peq[static_cast<unsigned char>(texts[i][j])];
+
+            const u64x4 xv { eq | mv };
+            const u64x4 xh { (((eq & pv) + pv) ^ pv) | eq };
+
+            u64x4 ph { mv | ~(xh | pv) };
+            u64x4 mh { pv & xh };
+
+            /* lanes whose text already ended keep their score */
+            const i64x4 active { static_cast<std::int64_t>(j) < len };
+            const i64x4 delta {
+                __builtin_convertvector((ph >> high_shift) & 1, i64x4)
+                - __builtin_convertvector((mh >> high_shift) & 1, i64x4)
+            };
+            score += delta & active;
+
+            ph = (ph << 1) | 1;
+            mh <<= 1;
+
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+
+            bool all_exceeded { true };
+            for (std::size_t i { 0 }; i < texts.size(); i++)
+            {
+                const std::int64_t remaining { std::max<std::int64_t>(
+                    len[i] - static_cast<std::int64_t>(j) - 1, 0) };
+                if (score[i] - remaining <= max) all_exceeded = false;
+            }
+
+            if (all_exceeded) break;
+        }
+
+        for (std::size_t i { 0 }; i < texts.size(); i++)
+        {
+            const std::int64_t remaining { std::max<std::int64_t>(
+                len[i] - static_cast<std::int64_t>(max_len), 0) };
+
+            results[i] = score[i] - remaining > max
+                           ? max + 1
+                           : static_cast<int>(std::min<std::int64_t>(
+                                 score[i], max + 1));
+        }
+    }
+}
+
+
 namespace utils::str
 {
     auto
@@ -79,10 +264,10 @@ namespace utils::str
 
 
     auto
-    trim(const std::string &str) -> std::string
+    trim(std::string_view str) -> std::string_view
     {
         const auto begin { str.find_first_not_of(" \t\n\r\f\v") };
-        if (begin == std::string::npos) return "";
+        if (begin == std::string_view::npos) return {};
 
         const auto end { str.find_last_not_of(" \t\n\r\f\v") };
         return str.substr(begin, end - begin + 1);
@@ -90,14 +275,11 @@ namespace utils::str
 
 
     auto
-    split(const std::string &str, std::size_t pos)
-        -> std::pair<std::string, std::string>
+    split(std::string_view str, std::size_t pos)
+        -> std::pair<std::string_view, std::string_view>
     {
-        if (pos == std::string::npos) return { str, "" };
-
-        std::string first { str.substr(0, pos) };
-        std::string second { str.substr(pos + 1) };
-        return { first, second };
+        if (pos == std::string_view::npos) return { str, {} };
+        return { str.substr(0, pos), str.substr(pos + 1) };
     }
 
 
@@ -112,26 +294,59 @@ namespace utils::str
 
 
     auto
-    levenshtein_distance(const std::string &a, const std::string &b) -> int
+    levenshtein_distance(std::string_view a, std::string_view b) -> int
     {
-        const std::spair<std::size_t>      LEN { a.length(), b.length() };
-        std::vector<std::vector<int>> dp { LEN.first + 1,
-                                           std::vector<int>(LEN.second + 1) };
+        const auto longest { static_cast<int>(
+            std::max(a.length(), b.length())) };
+
+        /* the distance can never exceed the length of the longer string */
+        return bounded_levenshtein_distance(a, b, longest);
+    }
+
+
+    auto
+    bounded_levenshtein_distance(std::string_view a,
+                                 std::string_view b,
+                                 int              max) -> int
+    {
+        /* the distance is symmetric, the shorter string is the pattern */
+        if (a.length() > b.length()) std::swap(a, b);
+
+        if (static_cast<int>(b.length() - a.length()) > max) return max + 1;
+        if (a.empty()) return static_cast<int>(b.length());
+
+        if (a.length() > MAX_PATTERN_LENGTH) return row_distance(a, b, max);
+
+        return myers_distance(make_peq_table(a), a.length(), b, max);
+    }
 
-        for (std::size_t i { 0 }; i <= LEN.first; i++) dp[i][0] = i;
-        for (std::size_t j { 0 }; j <= LEN.second; j++) dp[0][j] = j;
 
-        for (std::size_t i { 1 }; i <= LEN.first; i++)
+    auto
+    bounded_levenshtein_distance(std::string_view                  query,
+                                 std::span<const std::string_view> candidates,
+                                 int max) -> std::vector<int>
+    {
+        std::vector<int> results(candidates.size());
+
+        if (query.empty() || query.length() > MAX_PATTERN_LENGTH)
         {
-            for (std::size_t j { 1 }; j <= LEN.second; j++)
-            {
-                int cost { (a[i - 1] == b[j - 1]) ? 0 : 1 };
-                dp[i][j] = std::min({ dp[i - 1][j] + 1, dp[i][j - 1] + 1,
-                                      dp[i - 1][j - 1] + cost });
-            }
+            for (std::size_t i { 0 }; i < candidates.size(); i++)
+                results[i]
+                    = bounded_levenshtein_distance(query, candidates[i], max);
+            return results;
+        }
+
+        const peq_table peq { make_peq_table(query) };
+
+        for (std::size_t i { 0 }; i < candidates.size(); i += LANES)
+        {
+            auto chunk { candidates.subspan(
+                i, std::min(LANES, candidates.size() - i)) };
+            myers_distance_lanes(peq, query.length(), chunk, max,
+                                 results.data() + i);
         }
 
-        return dp[LEN.first][LEN.second];
+        return results;
     }
 
 
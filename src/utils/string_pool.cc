@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <mutex>
+
+#include "string_pool.hh"
+
+using utils::StringPool;
+
+
+auto
+StringPool::find_slot(std::string_view text, std::uint64_t hash) const
+    -> std::size_t
+{
+    const std::size_t mask { m_slots.size() - 1 };
+
+    for (std::size_t slot { hash & mask };; slot = (slot + 1) & mask)
+    {
+        if (m_slots[slot] == 0) return slot;
+
+        const Entry &entry { m_entries[m_slots[slot] - 1] };
+        if (entry.hash == hash && entry.text == text) return slot;
+    }
+}
+
+
+auto
+StringPool::copy_text(std::string_view text) -> std::string_view
+{
+    if (text.empty()) return {};
+
+    /* a text bigger than a block gets one of its own */
+    if (text.length() > BLOCK_SIZE)
+    {
+        auto &block { m_blocks.emplace_back(
+            std::make_unique<char[]>(text.length())) };
+        std::memcpy(block.get(), text.data(), text.length());
+        return { block.get(), text.length() };
+    }
+
+    if (m_block_used + text.length() > BLOCK_SIZE)
+    {
+        m_block = m_blocks.emplace_back(std::make_unique<char[]>(BLOCK_SIZE))
+                      .get();
+        m_block_used = 0;
+    }
+
+    char *data { m_block + m_block_used };
+    std::memcpy(data, text.data(), text.length());
+    m_block_used += text.length();
+    return { data, text.length() };
+}
+
+
+void
+StringPool::grow_index()
+{
+    m_slots.assign(std::max(MIN_SLOTS, m_slots.size() * 2), 0);
+
+    for (std::size_t i { 0 }; i < m_entries.size(); i++)
+        m_slots[find_slot(m_entries[i].text, m_entries[i].hash)]
+            = static_cast<std::uint32_t>(i + 1);
+}
+
+
+auto
+StringPool::intern(std::string_view text) -> id
+{
+    const std::uint64_t hash { std::hash<std::string_view> {}(text) };
+
+    {
+        std::shared_lock lock { m_mutex };
+
+        if (!m_slots.empty())
+            if (auto slot { m_slots[find_slot(text, hash)] }; slot != 0)
+                return slot - 1;
+    }
+
+    std::unique_lock lock { m_mutex };
+
+    /* another thread may have added it between the two locks */
+    if (!m_slots.empty())
+        if (auto slot { m_slots[find_slot(text, hash)] }; slot != 0)
+            return slot - 1;
+
+    if ((m_entries.size() + 1) * 2 > m_slots.size()) grow_index();
+
+    const auto text_id { static_cast<id>(m_entries.size()) };
+    m_entries.push_back({ copy_text(text), hash });
+    m_slots[find_slot(text, hash)] = text_id + 1;
+
+    return text_id;
+}
+
+
+auto
+StringPool::intern_view(std::string_view text) -> std::string_view
+{
+    return get(intern(text));
+}
+
+
+auto
+StringPool::find(std::string_view text) const -> std::optional<id>
+{
+    const std::uint64_t hash { std::hash<std::string_view> {}(text) };
+
+    std::shared_lock lock { m_mutex };
+    if (m_slots.empty()) return std::nullopt;
+
+    if (auto slot { m_slots[find_slot(text, hash)] }; slot != 0)
+        return slot - 1;
+    return std::nullopt;
+}
+
+
+auto
+StringPool::get(id text_id) const -> std::string_view
+{
+    std::shared_lock lock { m_mutex };
+    return m_entries[text_id].text;
+}
+
+
+auto
+StringPool::size() const -> std::size_t
+{
+    std::shared_lock lock { m_mutex };
+    return m_entries.size();
+}
+
+
+auto
+utils::get_string_pool() -> StringPool &
+{
+    static StringPool pool;
+    return pool;
+}
@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <cstring>
+#include <format>
 
 #include <json/reader.h>
 #include <json/writer.h>
@@ -121,6 +123,43 @@ namespace utils
         const auto *VALUE { std::getenv(env.c_str()) };
         return VALUE == nullptr ? val : VALUE;
     }
+
+
+    auto
+    get_cache_path() -> std::filesystem::path
+    {
+        std::string cache_path { getenv("XDG_HOME_CACHE",
+                                        getenv("HOME") + "/.cache") };
+
+        if (cache_path.empty()) throw std::runtime_error("$HOME is not set");
+
+        std::filesystem::path dir { std::format("{}/better/better-shell",
+                                                cache_path) };
+        std::filesystem::create_directories(dir);
+
+        return dir;
+    }
+
+
+    auto
+    hash_text(std::string_view text, std::uint64_t hash) -> std::uint64_t
+    {
+        constexpr std::uint64_t FNV_PRIME { 0x100000001b3 };
+
+        std::size_t i { 0 };
+        for (; i + sizeof(std::uint64_t) <= text.length();
+             i += sizeof(std::uint64_t))
+        {
+            std::uint64_t word;
+            std::memcpy(&word, text.data() + i, sizeof(word));
+            hash = (hash ^ word) * FNV_PRIME;
+        }
+
+        for (; i < text.length(); i++)
+            hash = (hash ^ static_cast<unsigned char>(text[i])) * FNV_PRIME;
+
+        return hash;
+    }
 } /* namespace utils */
 
 
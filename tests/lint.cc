@@ -0,0 +1,87 @@
+#include <array>
+#include <format>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+#include "parser/lint.hh"
+#include "parser/script.hh"
+#include "print.hh"
+
+
+namespace
+{
+    struct Case
+    {
+        std::string_view script;
+
+        /* the line of the error, starting from 1 as it is printed */
+        std::size_t line;
+        std::size_t column;
+    };
+
+
+    /* every error is past the first line of the script, so that a
+       position taken from inside its statement would not match */
+    constexpr std::array CASES {
+        Case { "echo a\necho b\n\necho c\necho d\nls {{ }}\necho e\n", 6, 3 },
+        Case { "echo a\necho {\n  ls\n} c\necho \"d\ne\"\nls {{ }}\n", 7, 3 },
+        Case { "echo a\necho b {\n  ls {{ }}\n}\n", 3, 5 },
+        Case { "echo a\n\n\nls {{ }}", 4, 3 },
+    };
+
+
+    /**
+     * checks that @p err points at @p line and @p column of the script,
+     * both in its header and in the line numbers it prints
+     */
+    [[nodiscard]]
+    auto
+    points_at(::error::Info &err, std::size_t line, std::size_t column)
+        -> bool
+    {
+        const std::string message { err.create_pretty_message() };
+
+        const std::string header { std::format(": {}:{}]", line - 1,
+                                               column) };
+        const std::string line_num { std::format(
+            "{}{}{}", ::error::color::LINE_NUM, line, ::error::color::RESET) };
+
+        return message.find(header) != std::string::npos
+            && message.find(line_num) != std::string::npos;
+    }
+}
+
+
+auto
+main() -> int
+{
+    int failures { 0 };
+
+    for (const auto &[script, line, column] : CASES)
+    {
+        auto errors { parser::lint_script(script, "test") };
+
+        /* the reader splits the script on its own, through a window
+           smaller than most of its statements */
+        std::istringstream   stream { std::string { script } };
+        parser::ScriptReader reader { stream, "test", 4 };
+
+        while (auto tokens { reader.next() })
+            if (auto err { tokens->verify_syntax(false) })
+                errors.push_back(std::move(*err));
+
+        if (errors.size() == 2 && points_at(errors[0], line, column)
+            && points_at(errors[1], line, column))
+            continue;
+
+        failures++;
+        io::println(std::cerr, "script:\n{}\nexpected {}:{}, got:", script,
+                    line, column);
+        for (auto &err : errors)
+            io::println(std::cerr, "{}", err.create_pretty_message());
+    }
+
+    return failures == 0 ? 0 : 1;
+}
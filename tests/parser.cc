@@ -0,0 +1,206 @@
+#include <array>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+#include "parser/parser.hh"
+#include "print.hh"
+#include "string_pool.hh"
+
+using namespace std::literals;
+
+
+namespace
+{
+    struct Case
+    {
+        std::string_view input;
+
+        /* one token per line, as written by dump() */
+        std::string_view tokens;
+
+        /* the error type of check_syntax(), or empty for none */
+        std::string_view error;
+    };
+
+
+    /* the substitution brackets are paired the same way the lexer reads
+       them, a '}' whose '{' was skipped or read as part of "{{" still
+       gets a token of its own */
+    constexpr std::array CASES {
+        Case { R"(echo "a"{{x}})",
+               "COMMAND@0 'echo'\n"
+               "STRING_QUOTE@5 '\"'\n"
+               "STRING_CONTENT@6 'a'\n"
+               "STRING_QUOTE@7 '\"'\n"
+               "SUB_BRACKET@9 '{'\n"
+               "SUB_CONTENT@10\n"
+               "  COMMAND@0 'x'\n"
+               "SUB_BRACKET@11 '}'\n"
+               "SUB_BRACKET@12 '}'\n",
+               "parser::UNCLOSED_BRACKET" },
+
+        Case { "ls 1+2x---longx{{--./nope}}{{",
+               "COMMAND@0 'ls'\n"
+               "FLAG@3 '1+2x'\n"
+               "PARAMETER@10 'longx'\n"
+               "SUB_BRACKET@16 '{'\n"
+               "SUB_CONTENT@17\n"
+               "  COMMAND@0 '--./nope'\n"
+               "SUB_BRACKET@25 '}'\n"
+               "SUB_BRACKET@26 '}'\n"
+               "SUB_BRACKET@28 '{'\n",
+               "parser::UNCLOSED_BRACKET" },
+
+        Case { "echo {a}}",
+               "COMMAND@0 'echo'\n"
+               "SUB_BRACKET@5 '{'\n"
+               "SUB_CONTENT@6\n"
+               "  COMMAND@0 'a'\n"
+               "SUB_BRACKET@7 '}'\n"
+               "SUB_BRACKET@8 '}'\n",
+               "parser::UNCLOSED_BRACKET" },
+
+        Case { "echo {a {b} c}}",
+               "COMMAND@0 'echo'\n"
+               "SUB_BRACKET@5 '{'\n"
+               "SUB_CONTENT@6\n"
+               "  COMMAND@0 'a'\n"
+               "  SUB_BRACKET@2 '{'\n"
+               "  SUB_CONTENT@3\n"
+               "    COMMAND@0 'b'\n"
+               "  SUB_BRACKET@4 '}'\n"
+               "  PARAMETER@6 'c'\n"
+               "SUB_BRACKET@13 '}'\n"
+               "SUB_BRACKET@14 '}'\n",
+               "parser::UNCLOSED_BRACKET" },
+
+        Case { R"(echo { "}" })",
+               "COMMAND@0 'echo'\n"
+               "SUB_BRACKET@5 '{'\n"
+               "SUB_CONTENT@6\n"
+               "  COMMAND@0 '\"}\"'\n"
+               "SUB_BRACKET@11 '}'\n",
+               "" },
+
+        Case { "echo }{",
+               "COMMAND@0 'echo'\n"
+               "FLAG@5 '}'\n"
+               "SUB_BRACKET@6 '{'\n",
+               "parser::UNCLOSED_BRACKET" },
+
+        Case { "echo a}b{c}",
+               "COMMAND@0 'echo'\n"
+               "FLAG@5 'a}b'\n"
+               "SUB_BRACKET@8 '{'\n"
+               "SUB_CONTENT@9\n"
+               "  COMMAND@0 'c'\n"
+               "SUB_BRACKET@10 '}'\n",
+               "" },
+
+        Case { "echo {x{{1}}y}",
+               "COMMAND@0 'echo'\n"
+               "SUB_BRACKET@5 '{'\n"
+               "SUB_CONTENT@6\n"
+               "  COMMAND@0 'x{{1}}y'\n"
+               "SUB_BRACKET@13 '}'\n",
+               "" },
+
+        Case { "echo {{{a}}",
+               "COMMAND@0 'echo'\n"
+               "ARITHMETIC_BRACKET@5 '{{'\n"
+               "ARITHMETIC_EXPRESSION@7 '{a'\n"
+               "ARITHMETIC_BRACKET@9 '}}'\n",
+               "parser::UNCLOSED_BRACKET" },
+    };
+
+
+    void
+    dump(const parser::TokenGroup &group, std::size_t level, std::string &out)
+    {
+        const parser::TokenList &tokens { group.tokens };
+
+        for (std::size_t i { 0 }; i < tokens.size(); i++)
+        {
+            out.append(level * 2, ' ');
+            out += parser::TokenType_to_string(tokens.get_type(i))
+                       .substr("Type::"sv.length());
+            out += '@';
+            out += std::to_string(tokens.get_index(i));
+
+            if (tokens.get_type(i) == parser::TokenType::SUB_CONTENT)
+            {
+                out += '\n';
+                dump(*tokens.get_group(i), level + 1, out);
+                continue;
+            }
+
+            out += " '";
+            out += *tokens.get_text(i);
+            out += "'\n";
+        }
+    }
+
+
+    /**
+     * checks that every token of @p group has the id of its text in the
+     * string pool, the tokens of the same text sharing the same id
+     */
+    [[nodiscard]]
+    auto
+    check_text_ids(const parser::TokenGroup &group) -> bool
+    {
+        const parser::TokenList &tokens { group.tokens };
+
+        for (std::size_t i { 0 }; i < tokens.size(); i++)
+        {
+            const auto text_id { tokens.get_text_id(i) };
+            if (!text_id
+                || utils::get_string_pool().get(*text_id)
+                       != *tokens.get_text(i))
+                return false;
+        }
+
+        return true;
+    }
+}
+
+
+auto
+main() -> int
+{
+    int failures { 0 };
+
+    for (const auto &[input, expected_tokens, expected_error] : CASES)
+    {
+        const auto group { parser::parse("test", std::string { input }) };
+
+        std::string tokens;
+        dump(*group, 0, tokens);
+
+        const auto       syntax { group->check_syntax() };
+        std::string_view error;
+        if (syntax.error) error = syntax.error->get_error_type();
+
+        if (tokens == expected_tokens && error == expected_error) continue;
+
+        failures++;
+        io::println(std::cerr, "input: {}", input);
+        io::println(std::cerr, "expected:\n{}{}", expected_tokens,
+                    expected_error);
+        io::println(std::cerr, "got:\n{}{}\n", tokens, error);
+    }
+
+    /* the commands, flags and paths are looked up in the string pool */
+    for (const std::string_view input : { "ls -la --all ./bin/x"sv,
+                                          "ls --all -al ./bin/x"sv })
+    {
+        if (check_text_ids(*parser::parse("test", std::string { input })))
+            continue;
+
+        failures++;
+        io::println(std::cerr, "input: {}\nmissing text ids", input);
+    }
+
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,209 @@
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "parser/parser.hh"
+#include "print.hh"
+
+using namespace std::literals;
+
+
+namespace
+{
+    constexpr std::size_t LINE_COUNT { 4000 };
+    constexpr std::size_t EDITS_PER_LINE { 12 };
+    constexpr std::size_t MAX_LINE_LENGTH { 48 };
+
+    /* most edits only touch words, some add or remove quotes and
+       brackets, which changes how the rest of the line is split */
+    constexpr std::string_view WORD_CHARS { "ab cd  -=|;&\\x\n" };
+    constexpr std::string_view ALL_CHARS { "ab cd  -=|;&{}\"\\x--=\n" };
+
+
+    /**
+     * writes everything parse() records about @p group and the groups
+     * it holds, so that two trees of the same text give the same dump
+     */
+    void
+    dump(const parser::TokenGroup &group, std::size_t level, std::string &out)
+    {
+        const parser::TokenList &tokens { group.tokens };
+        const auto               positions { tokens.get_positions() };
+
+        out.append(level * 2, ' ');
+        out += std::format("group@{} '{}'\n", group.offset, group.raw);
+
+        for (std::size_t i { 0 }; i < tokens.size(); i++)
+        {
+            const parser::Position &position { positions[i] };
+
+            out.append(level * 2, ' ');
+            out += std::format(
+                "{}@{} {}:{}:{}",
+                parser::TokenType_to_string(tokens.get_type(i))
+                    .substr("Type::"sv.length()),
+                tokens.get_index(i), position.offset, position.line,
+                position.column);
+
+            if (const parser::TokenGroup *child { tokens.get_group(i) })
+            {
+                out += '\n';
+                dump(*child, level + 1, out);
+                continue;
+            }
+
+            out += std::format(" '{}'", *tokens.get_text(i));
+            if (const auto text_id { tokens.get_text_id(i) })
+                out += std::format(" #{}", *text_id);
+            out += '\n';
+        }
+    }
+
+
+    [[nodiscard]]
+    auto
+    dump(const parser::TokenGroup &group) -> std::string
+    {
+        std::string out;
+        dump(group, 0, out);
+        return out;
+    }
+
+
+    /**
+     * checks that the groups held by @p group point back to it and to
+     * the top-level group, and view its text where they say they do
+     */
+    [[nodiscard]]
+    auto
+    check_links(const parser::TokenGroup &group) -> bool
+    {
+        const parser::TokenGroup *toplevel { group.get_toplevel() };
+
+        for (std::size_t i { 0 }; i < group.tokens.size(); i++)
+        {
+            const parser::TokenGroup *child { group.tokens.get_group(i) };
+            if (child == nullptr) continue;
+
+            if (child->parent != &group || child->get_toplevel() != toplevel
+                || child->raw.data() != toplevel->raw.data() + child->offset
+                || !check_links(*child))
+                return false;
+        }
+
+        return true;
+    }
+
+
+    /**
+     * changes the first text of every group held by @p group
+     */
+    void
+    change_groups(parser::TokenGroup &group)
+    {
+        for (std::size_t i { 0 }; i < group.tokens.size(); i++)
+        {
+            parser::TokenGroup *child { group.tokens.get_group(i) };
+            if (child == nullptr) continue;
+
+            if (child->tokens.get_text(0)) child->set_text(0, "changed");
+            change_groups(*child);
+        }
+    }
+
+
+    class Fuzzer
+    {
+    public:
+        explicit Fuzzer(std::uint32_t seed) : m_random(seed) {}
+
+
+        [[nodiscard]]
+        auto
+        pick(std::size_t count) -> std::size_t
+        {
+            return m_random() % count;
+        }
+
+
+        [[nodiscard]]
+        auto
+        make_text(std::string_view chars, std::size_t length) -> std::string
+        {
+            std::string text;
+            for (std::size_t i { 0 }; i < length; i++)
+                text += chars[pick(chars.length())];
+            return text;
+        }
+
+    private:
+        std::mt19937 m_random;
+    };
+}
+
+
+/**
+ * applies random edits to random lines, and checks that reparse() gives
+ * the same tokens as parsing the edited text from scratch, without
+ * changing the tree it reparsed
+ */
+auto
+main() -> int
+{
+    Fuzzer      fuzzer { 1 };
+    std::size_t checked { 0 };
+    std::size_t failures { 0 };
+
+    for (std::size_t line { 0 }; line < LINE_COUNT && failures == 0; line++)
+    {
+        std::string text { fuzzer.make_text(
+            ALL_CHARS, 1 + fuzzer.pick(MAX_LINE_LENGTH)) };
+        auto tokens { parser::parse("test", text) };
+
+        for (std::size_t e { 0 }; e < EDITS_PER_LINE; e++)
+        {
+            const std::size_t offset { fuzzer.pick(text.length() + 1) };
+            const std::size_t removed { fuzzer.pick(
+                std::min<std::size_t>(4, text.length() - offset) + 1) };
+            const std::string inserted { fuzzer.make_text(
+                fuzzer.pick(5) == 0 ? ALL_CHARS : WORD_CHARS,
+                fuzzer.pick(4)) };
+
+            std::string edited { text };
+            edited.replace(offset, removed, inserted);
+            if (edited.find_first_not_of(" \t\n\v\f\r") == std::string::npos)
+                break;
+
+            const std::string before { dump(*tokens) };
+            const parser::Edit edit { offset, removed, inserted };
+
+            const auto reparsed { parser::reparse(tokens, edit) };
+            const auto expected { dump(*parser::parse("test", edited)) };
+
+            /* the reparsed tree shares groups with the old one, changing
+               them must leave the old one as it was */
+            change_groups(*parser::reparse(tokens, edit));
+
+            checked++;
+            if (dump(*reparsed) == expected && check_links(*reparsed)
+                && dump(*tokens) == before)
+            {
+                text   = std::move(edited);
+                tokens = reparsed;
+                continue;
+            }
+
+            failures++;
+            io::println(std::cerr, "text: '{}'", text);
+            io::println(std::cerr, "edit: {} {} '{}'", offset, removed,
+                        inserted);
+            io::println(std::cerr, "expected:\n{}", expected);
+            io::println(std::cerr, "got:\n{}", dump(*reparsed));
+            break;
+        }
+    }
+
+    io::println("{} edits checked", checked);
+    return failures == 0 ? 0 : 1;
+}